@@ -123,6 +123,24 @@ int container_linux::text_width( const litehtml::tchar_t* text, litehtml::uint_p
 	return (int) ext.x_advance;
 }
 
+void container_linux::text_widths( const litehtml::tchar_t* const* texts, int count, litehtml::uint_ptr hFont, int* widths )
+{
+	cairo_font* fnt = (cairo_font*) hFont;
+
+	cairo_save(m_temp_cr);
+
+	cairo_set_font_size(m_temp_cr, fnt->size);
+	cairo_set_font_face(m_temp_cr, fnt->font);
+	cairo_text_extents_t ext;
+	for(int i = 0; i < count; i++)
+	{
+		cairo_text_extents(m_temp_cr, texts[i], &ext);
+		widths[i] = (int) ext.x_advance;
+	}
+
+	cairo_restore(m_temp_cr);
+}
+
 void container_linux::draw_text( litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos )
 {
 	cairo_font* fnt = (cairo_font*) hFont;
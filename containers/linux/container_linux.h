@@ -53,6 +53,7 @@ public:
 	virtual litehtml::uint_ptr			create_font(const litehtml::tchar_t* faceName, int size, int weight, litehtml::font_style italic, unsigned int decoration, litehtml::font_metrics* fm) override;
 	virtual void						delete_font(litehtml::uint_ptr hFont) override;
 	virtual int						text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont) override;
+	virtual void					text_widths(const litehtml::tchar_t* const* texts, int count, litehtml::uint_ptr hFont, int* widths) override;
 	virtual void						draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) override;
 	virtual int						pt_to_px(int pt) override;
 	virtual int						get_default_font_size() const override;
@@ -0,0 +1,310 @@
+#include "container_metrics.h"
+#include <cctype>
+
+namespace
+{
+	// advances of the printable ASCII characters in 1/1000 em, from a common sans-serif face
+	const int proportional_ascii[95] =
+	{
+		278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,		// space - /
+		556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,		// 0 - ?
+		1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,	// @ - O
+		667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,		// P - _
+		333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,		// ` - o
+		556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584			// p - ~
+	};
+
+	const int monospace_advance		= 600;
+	const int proportional_default	= 556;
+
+	bool is_wide(unsigned int ch)
+	{
+		return	(ch >= 0x1100 && ch <= 0x115F) ||	// hangul jamo
+				(ch >= 0x2E80 && ch <= 0xA4CF) ||	// cjk radicals to yi
+				(ch >= 0xAC00 && ch <= 0xD7A3) ||	// hangul syllables
+				(ch >= 0xF900 && ch <= 0xFAFF) ||	// cjk compatibility ideographs
+				(ch >= 0xFE30 && ch <= 0xFE4F) ||	// cjk compatibility forms
+				(ch >= 0xFF00 && ch <= 0xFF60) ||	// full width forms
+				(ch >= 0xFFE0 && ch <= 0xFFE6) ||
+				(ch >= 0x20000 && ch <= 0x3FFFD);	// supplementary ideographs
+	}
+
+	bool is_combining(unsigned int ch)
+	{
+		return (ch >= 0x0300 && ch <= 0x036F) || ch == 0x200B || ch == 0xFEFF;
+	}
+}
+
+container_metrics::container_metrics()
+{
+	m_client				= litehtml::position(0, 0, 800, 600);
+	m_text_width_calls		= 0;
+}
+
+container_metrics::~container_metrics()
+{
+}
+
+void container_metrics::set_client_size(int width, int height)
+{
+	m_client.width	= width;
+	m_client.height	= height;
+}
+
+void container_metrics::set_image_size(const litehtml::tchar_t* src, int width, int height)
+{
+	litehtml::size& sz = m_images[src];
+	sz.width	= width;
+	sz.height	= height;
+}
+
+void container_metrics::set_default_image_size(int width, int height)
+{
+	m_default_image.width	= width;
+	m_default_image.height	= height;
+}
+
+int container_metrics::load_image_manifest(const litehtml::tchar_t* manifest)
+{
+	int ret = 0;
+	litehtml::string_vector lines;
+	litehtml::split_string(manifest, lines, _t("\n"));
+	for(litehtml::string_vector::iterator line = lines.begin(); line != lines.end(); line++)
+	{
+		litehtml::trim(*line);
+		if(line->empty() || (*line)[0] == _t('#'))
+		{
+			continue;
+		}
+		litehtml::string_vector tokens;
+		litehtml::split_string(*line, tokens, _t(" \t"));
+		if(tokens.size() == 3)
+		{
+			set_image_size(tokens[0].c_str(), t_atoi(tokens[1].c_str()), t_atoi(tokens[2].c_str()));
+			ret++;
+		}
+	}
+	return ret;
+}
+
+void container_metrics::reset_counts()
+{
+	m_counts			= draw_counts();
+	m_text_width_calls	= 0;
+}
+
+litehtml::uint_ptr container_metrics::create_font(const litehtml::tchar_t* faceName, int size, int weight, litehtml::font_style italic, unsigned int decoration, litehtml::font_metrics* fm)
+{
+	litehtml::tstring face = faceName ? faceName : _t("");
+	litehtml::lcase(face);
+
+	font fnt;
+	fnt.monospace	= face.find(_t("mono")) != litehtml::tstring::npos || face.find(_t("courier")) != litehtml::tstring::npos;
+	fnt.size		= size;
+	fnt.weight		= weight;
+	fnt.decoration	= decoration;
+	m_fonts.push_back(fnt);
+
+	if(fm)
+	{
+		fm->ascent		= size * 4 / 5;
+		fm->descent		= size - fm->ascent;
+		fm->height		= size + size / 5;
+		fm->x_height	= size / 2;
+		fm->draw_spaces	= italic == litehtml::fontStyleItalic || decoration;
+	}
+	return (litehtml::uint_ptr) m_fonts.size();
+}
+
+void container_metrics::delete_font(litehtml::uint_ptr hFont)
+{
+}
+
+unsigned int container_metrics::next_char(const litehtml::tchar_t*& str)
+{
+	unsigned int ch = (unsigned int) *str++;
+	if(sizeof(litehtml::tchar_t) > 1)
+	{
+		return ch;
+	}
+	ch &= 0xFF;
+	int tail = 0;
+	if(ch >= 0xF0)		{ ch &= 0x07; tail = 3; }
+	else if(ch >= 0xE0)	{ ch &= 0x0F; tail = 2; }
+	else if(ch >= 0xC0)	{ ch &= 0x1F; tail = 1; }
+	for(; tail > 0 && (*str & 0xC0) == 0x80; tail--)
+	{
+		ch = (ch << 6) | (*str++ & 0x3F);
+	}
+	return ch;
+}
+
+int container_metrics::char_advance(const font& fnt, unsigned int ch)
+{
+	if(is_combining(ch))
+	{
+		return 0;
+	}
+	if(fnt.monospace)
+	{
+		return is_wide(ch) ? monospace_advance * 2 : monospace_advance;
+	}
+	if(ch >= 0x20 && ch < 0x7F)
+	{
+		return proportional_ascii[ch - 0x20];
+	}
+	return is_wide(ch) ? 1000 : proportional_default;
+}
+
+int container_metrics::text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont)
+{
+	m_text_width_calls++;
+	if(!hFont || hFont > m_fonts.size())
+	{
+		return 0;
+	}
+	const font& fnt = m_fonts[hFont - 1];
+
+	// the advances are summed in 1/1000 em and rounded once, so the widths of words add up like real text
+	long long width = 0;
+	for(const litehtml::tchar_t* str = text; *str;)
+	{
+		width += char_advance(fnt, next_char(str));
+	}
+	if(fnt.weight >= 600 && !fnt.monospace)
+	{
+		width += width / 20;
+	}
+	return (int) ((width * fnt.size + 500) / 1000);
+}
+
+void container_metrics::draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos)
+{
+	m_counts.text++;
+}
+
+void container_metrics::draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color)
+{
+	m_counts.text_runs++;
+}
+
+int container_metrics::pt_to_px(int pt)
+{
+	return pt * 96 / 72;
+}
+
+int container_metrics::get_default_font_size() const
+{
+	return 16;
+}
+
+const litehtml::tchar_t* container_metrics::get_default_font_name() const
+{
+	return _t("Times New Roman");
+}
+
+void container_metrics::load_image(const litehtml::tchar_t* src, const litehtml::tchar_t* baseurl, bool redraw_on_ready)
+{
+}
+
+void container_metrics::get_image_size(const litehtml::tchar_t* src, const litehtml::tchar_t* baseurl, litehtml::size& sz)
+{
+	std::map<litehtml::tstring, litehtml::size>::const_iterator img = m_images.find(src ? src : _t(""));
+	sz = img != m_images.end() ? img->second : m_default_image;
+}
+
+void container_metrics::draw_background(litehtml::uint_ptr hdc, const litehtml::background_paint& bg)
+{
+	m_counts.backgrounds++;
+}
+
+void container_metrics::draw_borders(litehtml::uint_ptr hdc, const litehtml::borders& borders, const litehtml::position& draw_pos, bool root)
+{
+	m_counts.borders++;
+}
+
+void container_metrics::draw_list_marker(litehtml::uint_ptr hdc, const litehtml::list_marker& marker)
+{
+	m_counts.list_markers++;
+}
+
+std::shared_ptr<litehtml::element> container_metrics::create_element(const litehtml::tchar_t* tag_name, const litehtml::string_map& attributes, const std::shared_ptr<litehtml::document>& doc)
+{
+	return 0;
+}
+
+void container_metrics::get_media_features(litehtml::media_features& media) const
+{
+	media.type			= litehtml::media_type_screen;
+	media.width			= m_client.width;
+	media.height		= m_client.height;
+	media.device_width	= m_client.width;
+	media.device_height	= m_client.height;
+	media.color			= 8;
+	media.monochrome	= 0;
+	media.color_index	= 256;
+	media.resolution	= 96;
+}
+
+void container_metrics::get_language(litehtml::tstring& language, litehtml::tstring& culture) const
+{
+	language	= _t("en");
+	culture		= _t("");
+}
+
+void container_metrics::link(const std::shared_ptr<litehtml::document>& doc, const litehtml::element::ptr& el)
+{
+}
+
+void container_metrics::transform_text(litehtml::tstring& text, litehtml::text_transform tt)
+{
+	// ASCII only, which keeps the widths independent of the locale
+	for(litehtml::tstring::iterator ch = text.begin(); ch != text.end(); ch++)
+	{
+		if((unsigned) *ch > 0x7F)
+		{
+			continue;
+		}
+		if(tt == litehtml::text_transform_uppercase || (tt == litehtml::text_transform_capitalize && (ch == text.begin() || *(ch - 1) == _t(' '))))
+		{
+			*ch = (litehtml::tchar_t) toupper(*ch);
+		} else if(tt == litehtml::text_transform_lowercase)
+		{
+			*ch = (litehtml::tchar_t) tolower(*ch);
+		}
+	}
+}
+
+void container_metrics::set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y)
+{
+	m_counts.clips++;
+}
+
+void container_metrics::del_clip()
+{
+}
+
+void container_metrics::set_caption(const litehtml::tchar_t* caption)
+{
+}
+
+void container_metrics::set_base_url(const litehtml::tchar_t* base_url)
+{
+}
+
+void container_metrics::on_anchor_click(const litehtml::tchar_t* url, const litehtml::element::ptr& el)
+{
+}
+
+void container_metrics::set_cursor(const litehtml::tchar_t* cursor)
+{
+}
+
+void container_metrics::import_css(litehtml::tstring& text, const litehtml::tstring& url, litehtml::tstring& baseurl)
+{
+}
+
+void container_metrics::get_client_rect(litehtml::position& client) const
+{
+	client = m_client;
+}
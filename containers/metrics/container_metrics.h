@@ -0,0 +1,112 @@
+#ifndef LH_CONTAINER_METRICS_H
+#define LH_CONTAINER_METRICS_H
+
+#include "../../include/litehtml.h"
+#include <map>
+
+// headless container with synthetic font metrics, for reproducible layout tests and benchmarks;
+// faces containing "mono" or "courier" get the monospace font, everything else the proportional one
+class container_metrics : public litehtml::document_container
+{
+public:
+	struct draw_counts
+	{
+		int	text;
+		int	text_runs;
+		int	backgrounds;
+		int	borders;
+		int	list_markers;
+		int	clips;
+
+		draw_counts()
+		{
+			text			= 0;
+			text_runs		= 0;
+			backgrounds		= 0;
+			borders			= 0;
+			list_markers	= 0;
+			clips			= 0;
+		}
+		int total() const
+		{
+			return text + text_runs + backgrounds + borders + list_markers + clips;
+		}
+	};
+
+protected:
+	struct font
+	{
+		bool			monospace;
+		int				size;
+		int				weight;
+		unsigned int	decoration;
+	};
+
+	std::vector<font>							m_fonts;
+
+	// decodes one character and moves str past it
+	static unsigned int			next_char(const litehtml::tchar_t*& str);
+	// advance of ch in 1/1000 em, without the extra width of a bold font
+	static int					char_advance(const font& fnt, unsigned int ch);
+
+private:
+	std::map<litehtml::tstring, litehtml::size>	m_images;
+	litehtml::size								m_default_image;
+	litehtml::position							m_client;
+	draw_counts									m_counts;
+	int											m_text_width_calls;
+
+public:
+	container_metrics();
+	virtual ~container_metrics();
+
+	void						set_client_size(int width, int height);
+	void						set_image_size(const litehtml::tchar_t* src, int width, int height);
+	void						set_default_image_size(int width, int height);
+	// one image per line: "src width height"; lines starting with # are comments
+	int							load_image_manifest(const litehtml::tchar_t* manifest);
+	const draw_counts&			counts() const;
+	int							text_width_calls() const;
+	void						reset_counts();
+
+	virtual litehtml::uint_ptr			create_font(const litehtml::tchar_t* faceName, int size, int weight, litehtml::font_style italic, unsigned int decoration, litehtml::font_metrics* fm) override;
+	virtual void						delete_font(litehtml::uint_ptr hFont) override;
+	virtual int							text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont) override;
+	virtual void						draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) override;
+	virtual void						draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color) override;
+	virtual int							pt_to_px(int pt) override;
+	virtual int							get_default_font_size() const override;
+	virtual const litehtml::tchar_t*	get_default_font_name() const override;
+	virtual void						load_image(const litehtml::tchar_t* src, const litehtml::tchar_t* baseurl, bool redraw_on_ready) override;
+	virtual void						get_image_size(const litehtml::tchar_t* src, const litehtml::tchar_t* baseurl, litehtml::size& sz) override;
+	virtual void						draw_background(litehtml::uint_ptr hdc, const litehtml::background_paint& bg) override;
+	virtual void						draw_borders(litehtml::uint_ptr hdc, const litehtml::borders& borders, const litehtml::position& draw_pos, bool root) override;
+	virtual void						draw_list_marker(litehtml::uint_ptr hdc, const litehtml::list_marker& marker) override;
+	virtual std::shared_ptr<litehtml::element>	create_element(const litehtml::tchar_t* tag_name,
+																 const litehtml::string_map& attributes,
+																 const std::shared_ptr<litehtml::document>& doc) override;
+	virtual void						get_media_features(litehtml::media_features& media) const override;
+	virtual void						get_language(litehtml::tstring& language, litehtml::tstring& culture) const override;
+	virtual void						link(const std::shared_ptr<litehtml::document>& doc, const litehtml::element::ptr& el) override;
+	virtual void						transform_text(litehtml::tstring& text, litehtml::text_transform tt) override;
+	virtual void						set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y) override;
+	virtual void						del_clip() override;
+	virtual void						set_caption(const litehtml::tchar_t* caption) override;
+	virtual void						set_base_url(const litehtml::tchar_t* base_url) override;
+	virtual void						on_anchor_click(const litehtml::tchar_t* url, const litehtml::element::ptr& el) override;
+	virtual void						set_cursor(const litehtml::tchar_t* cursor) override;
+	virtual void						import_css(litehtml::tstring& text, const litehtml::tstring& url, litehtml::tstring& baseurl) override;
+	virtual void						get_client_rect(litehtml::position& client) const override;
+};
+
+inline const container_metrics::draw_counts& container_metrics::counts() const
+{
+	return m_counts;
+}
+
+inline int container_metrics::text_width_calls() const
+{
+	return m_text_width_calls;
+}
+
+#endif  // LH_CONTAINER_METRICS_H
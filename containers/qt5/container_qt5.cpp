@@ -53,6 +53,9 @@ container_qt5::~container_qt5()
 void container_qt5::set_document(std::shared_ptr< litehtml::document > doc)
 {
     _doc = doc;
+    _doc->set_track_damage(true);
+    // replaying the display list hands the words of a line over as one text run
+    _doc->set_record_display_list(true);
 }
 
 void container_qt5::paintEvent(QPaintEvent *event)
@@ -61,28 +64,42 @@ void container_qt5::paintEvent(QPaintEvent *event)
     painter.setRenderHint(QPainter::Antialiasing);
     qDebug() << __FUNCTION__ << width();
     _doc->render(width());
-    _doc->draw((litehtml::uint_ptr) &painter, 0, 0, nullptr);
+    // this paint already covers whatever the render moved
+    litehtml::position::vector damage;
+    _doc->take_damage(damage);
+    litehtml::position clip(event->rect().x(), event->rect().y(), event->rect().width(), event->rect().height());
+    _doc->draw((litehtml::uint_ptr) &painter, 0, 0, &clip);
+}
+
+void container_qt5::updateDamage()
+{
+    // repaint only the boxes the style change and the relayout touched
+    _doc->render(width());
+    litehtml::position::vector damage;
+    _doc->take_damage(damage);
+    for (const litehtml::position& box : damage)
+        update(getRect(box));
 }
 
 void container_qt5::mouseMoveEvent(QMouseEvent *event)
 {
     litehtml::position::vector vec;
     if (_doc->on_mouse_over(event->x(), event->y(), event->x(), event->y(), vec))
-        repaint();
+        updateDamage();
 }
 
 void container_qt5::mousePressEvent(QMouseEvent *event)
 {
     litehtml::position::vector vec;
     if (_doc->on_lbutton_down(event->x(), event->y(), event->x(), event->y(), vec))
-        repaint();
+        updateDamage();
 }
 
 void container_qt5::mouseReleaseEvent(QMouseEvent *event)
 {
     litehtml::position::vector vec;
     if (_doc->on_lbutton_up(event->x(), event->y(), event->x(), event->y(), vec))
-        repaint();
+        updateDamage();
 }
 
 void container_qt5::get_language(litehtml::tstring& language, litehtml::tstring& culture) const
@@ -318,6 +335,18 @@ void container_qt5::draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* t
     painter->drawText(pos.x, pos.bottom() - metrics.descent(), text);
 }
 
+void container_qt5::draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color)
+{
+    QPainter *painter = (QPainter *) hdc;
+    QFont *font = (QFont *) hFont;
+    painter->setFont(*font);
+    painter->setPen(getColor(color));
+    QFontMetrics metrics(*font);
+
+    for (int i = 0; i < count; i++)
+        painter->drawText(positions[i].x, positions[i].bottom() - metrics.descent(), texts[i]);
+}
+
 int container_qt5::text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont)
 {
     qDebug() << __FUNCTION__;
@@ -331,6 +360,17 @@ int container_qt5::text_width(const litehtml::tchar_t* text, litehtml::uint_ptr
     return metrics.boundingRect(txt).width();
 }
 
+void container_qt5::text_widths(const litehtml::tchar_t* const* texts, int count, litehtml::uint_ptr hFont, int* widths)
+{
+    QFont *font = (QFont *) hFont;
+    QFontMetrics metrics(*font);
+    int space_width = metrics.boundingRect("x").width();
+    for (int i = 0; i < count; i++) {
+        QString txt(texts[i]);
+        widths[i] = (txt == " ") ? space_width : metrics.boundingRect(txt).width();
+    }
+}
+
 void container_qt5::delete_font(litehtml::uint_ptr hFont)
 {
     qDebug() << __FUNCTION__;
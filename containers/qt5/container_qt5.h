@@ -36,6 +36,8 @@ protected:
     virtual void mousePressEvent(QMouseEvent *event) override;
     virtual void mouseReleaseEvent(QMouseEvent *event) override;
 
+    void updateDamage();
+
 public:
     /**
      * Default constructor
@@ -245,6 +247,7 @@ public:
      * @return TODO
      */
     virtual void draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) override;
+    virtual void draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color) override;
 
     /**
      * @todo write docs
@@ -254,6 +257,7 @@ public:
      * @return TODO
      */
     virtual int text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont) override;
+    virtual void text_widths(const litehtml::tchar_t* const* texts, int count, litehtml::uint_ptr hFont, int* widths) override;
 
     /**
      * @todo write docs
@@ -0,0 +1,686 @@
+#include "container_raster.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	// the printable ASCII characters as 5 columns of 7 rows, bit 0 is the top row
+	const unsigned char glyphs_5x7[95][5] =
+	{
+		{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },	// space ! " #
+		{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },	// $ % & '
+		{ 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x14, 0x08, 0x3E, 0x08, 0x14 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },	// ( ) * +
+		{ 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },	// , - . /
+		{ 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },	// 0 1 2 3
+		{ 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },	// 4 5 6 7
+		{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },	// 8 9 : ;
+		{ 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },	// < = > ?
+		{ 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },	// @ A B C
+		{ 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },	// D E F G
+		{ 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },	// H I J K
+		{ 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },	// L M N O
+		{ 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },	// P Q R S
+		{ 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },	// T U V W
+		{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },	// X Y Z [
+		{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },	// \ ] ^ _
+		{ 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },	// ` a b c
+		{ 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },	// d e f g
+		{ 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },	// h i j k
+		{ 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },	// l m n o
+		{ 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },	// p q r s
+		{ 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },	// t u v w
+		{ 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },	// x y z {
+		{ 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },									// | } ~
+	};
+
+	bool in_corner(double x, double y, double cx, double cy, int rx, int ry)
+	{
+		double dx = (x - cx) / rx;
+		double dy = (y - cy) / ry;
+		return dx * dx + dy * dy <= 1.0;
+	}
+
+	// x and y are the center of a pixel
+	bool inside_rounded(double x, double y, const litehtml::position& box, const litehtml::border_radiuses& r)
+	{
+		if(x < box.left() || x >= box.right() || y < box.top() || y >= box.bottom())
+		{
+			return false;
+		}
+		if(r.top_left_x > 0 && r.top_left_y > 0 && x < box.left() + r.top_left_x && y < box.top() + r.top_left_y)
+		{
+			return in_corner(x, y, box.left() + r.top_left_x, box.top() + r.top_left_y, r.top_left_x, r.top_left_y);
+		}
+		if(r.top_right_x > 0 && r.top_right_y > 0 && x > box.right() - r.top_right_x && y < box.top() + r.top_right_y)
+		{
+			return in_corner(x, y, box.right() - r.top_right_x, box.top() + r.top_right_y, r.top_right_x, r.top_right_y);
+		}
+		if(r.bottom_right_x > 0 && r.bottom_right_y > 0 && x > box.right() - r.bottom_right_x && y > box.bottom() - r.bottom_right_y)
+		{
+			return in_corner(x, y, box.right() - r.bottom_right_x, box.bottom() - r.bottom_right_y, r.bottom_right_x, r.bottom_right_y);
+		}
+		if(r.bottom_left_x > 0 && r.bottom_left_y > 0 && x < box.left() + r.bottom_left_x && y > box.bottom() - r.bottom_left_y)
+		{
+			return in_corner(x, y, box.left() + r.bottom_left_x, box.bottom() - r.bottom_left_y, r.bottom_left_x, r.bottom_left_y);
+		}
+		return true;
+	}
+
+	bool has_radius(const litehtml::border_radiuses& r)
+	{
+		return	(r.top_left_x > 0 && r.top_left_y > 0) || (r.top_right_x > 0 && r.top_right_y > 0) ||
+				(r.bottom_right_x > 0 && r.bottom_right_y > 0) || (r.bottom_left_x > 0 && r.bottom_left_y > 0);
+	}
+
+	// the dots, dashes and double lines are cut by the depth into the border and the distance along it
+	bool border_pixel(const litehtml::border& brd, double depth, int along)
+	{
+		int w = std::max(brd.width, 1);
+		switch(brd.style)
+		{
+		case litehtml::border_style_none:
+		case litehtml::border_style_hidden:
+			return false;
+		case litehtml::border_style_dotted:
+			return along % (w * 2) < w;
+		case litehtml::border_style_dashed:
+			return along % (w * 5) < w * 3;
+		case litehtml::border_style_double:
+			return brd.width < 3 || depth < brd.width / 3.0 || depth >= brd.width - brd.width / 3.0;
+		default:
+			return true;
+		}
+	}
+
+	void put_be32(std::vector<unsigned char>& out, unsigned int val)
+	{
+		out.push_back((unsigned char) (val >> 24));
+		out.push_back((unsigned char) (val >> 16));
+		out.push_back((unsigned char) (val >> 8));
+		out.push_back((unsigned char) val);
+	}
+
+	struct crc_table
+	{
+		unsigned int values[256];
+
+		crc_table()
+		{
+			for(unsigned int n = 0; n < 256; n++)
+			{
+				unsigned int c = n;
+				for(int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				values[n] = c;
+			}
+		}
+	};
+
+	unsigned int crc32(const unsigned char* data, size_t len)
+	{
+		// the initialization of a local static is thread safe, containers on several threads write images
+		static const crc_table table;
+		unsigned int crc = 0xFFFFFFFFu;
+		for(size_t i = 0; i < len; i++)
+		{
+			crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	void write_chunk(FILE* file, const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> chunk;
+		put_be32(chunk, (unsigned int) data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		put_be32(chunk, crc32(&chunk[4], chunk.size() - 4));
+		fwrite(&chunk[0], 1, chunk.size(), file);
+	}
+}
+
+container_raster::container_raster(int width, int height)
+{
+	resize(width, height);
+}
+
+container_raster::~container_raster()
+{
+}
+
+void container_raster::resize(int width, int height)
+{
+	m_width		= std::max(width, 0);
+	m_height	= std::max(height, 0);
+	m_pixels.assign((size_t) m_width * m_height * 4, 0xFF);
+	m_clips.clear();
+	set_client_size(m_width, m_height);
+	update_clip_rect();
+}
+
+void container_raster::clear(litehtml::web_color color)
+{
+	for(size_t i = 0; i < m_pixels.size(); i += 4)
+	{
+		m_pixels[i]		= color.red;
+		m_pixels[i + 1]	= color.green;
+		m_pixels[i + 2]	= color.blue;
+		m_pixels[i + 3]	= color.alpha;
+	}
+}
+
+litehtml::web_color container_raster::pixel(int x, int y) const
+{
+	if(x < 0 || y < 0 || x >= m_width || y >= m_height)
+	{
+		return litehtml::web_color(0, 0, 0, 0);
+	}
+	const unsigned char* px = &m_pixels[((size_t) y * m_width + x) * 4];
+	return litehtml::web_color(px[0], px[1], px[2], px[3]);
+}
+
+int container_raster::compare(const container_raster& other, int tolerance) const
+{
+	if(m_width != other.m_width || m_height != other.m_height)
+	{
+		return -1;
+	}
+	int ret = 0;
+	for(size_t i = 0; i < m_pixels.size(); i += 4)
+	{
+		for(int ch = 0; ch < 4; ch++)
+		{
+			if(abs((int) m_pixels[i + ch] - (int) other.m_pixels[i + ch]) > tolerance)
+			{
+				ret++;
+				break;
+			}
+		}
+	}
+	return ret;
+}
+
+bool container_raster::write_ppm(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if(!file)
+	{
+		return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", m_width, m_height);
+	std::vector<unsigned char> row((size_t) m_width * 3);
+	for(int y = 0; y < m_height; y++)
+	{
+		for(int x = 0; x < m_width; x++)
+		{
+			const unsigned char* px = &m_pixels[((size_t) y * m_width + x) * 4];
+			row[x * 3]		= px[0];
+			row[x * 3 + 1]	= px[1];
+			row[x * 3 + 2]	= px[2];
+		}
+		if(m_width)
+		{
+			fwrite(&row[0], 1, row.size(), file);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+bool container_raster::read_ppm(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file)
+	{
+		return false;
+	}
+	// the header is P6, the width, the height and the maximum value, with # comments in between
+	int values[3] = { 0, 0, 0 };
+	bool ok = fgetc(file) == 'P' && fgetc(file) == '6';
+	for(int i = 0; ok && i < 3; i++)
+	{
+		int ch = fgetc(file);
+		while(ch == '#' || isspace(ch))
+		{
+			if(ch == '#')
+			{
+				while(ch != '\n' && ch != EOF) ch = fgetc(file);
+			}
+			ch = fgetc(file);
+		}
+		ungetc(ch, file);
+		ok = fscanf(file, "%d", &values[i]) == 1;
+	}
+	ok = ok && values[2] == 255 && isspace(fgetc(file));
+	if(ok)
+	{
+		resize(values[0], values[1]);
+		std::vector<unsigned char> rgb((size_t) m_width * m_height * 3);
+		ok = rgb.empty() || fread(&rgb[0], 1, rgb.size(), file) == rgb.size();
+		for(size_t i = 0; ok && i < rgb.size() / 3; i++)
+		{
+			m_pixels[i * 4]		= rgb[i * 3];
+			m_pixels[i * 4 + 1]	= rgb[i * 3 + 1];
+			m_pixels[i * 4 + 2]	= rgb[i * 3 + 2];
+			m_pixels[i * 4 + 3]	= 0xFF;
+		}
+	}
+	fclose(file);
+	return ok;
+}
+
+bool container_raster::write_png(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if(!file)
+	{
+		return false;
+	}
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	fwrite(signature, 1, sizeof(signature), file);
+
+	std::vector<unsigned char> header;
+	put_be32(header, (unsigned int) m_width);
+	put_be32(header, (unsigned int) m_height);
+	header.push_back(8);	// bit depth
+	header.push_back(6);	// RGBA
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	write_chunk(file, "IHDR", header);
+
+	// every row starts with the filter type 0
+	size_t row_size = (size_t) m_width * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((row_size + 1) * m_height);
+	for(int y = 0; y < m_height; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), m_pixels.begin() + y * row_size, m_pixels.begin() + (y + 1) * row_size);
+	}
+
+	// a zlib stream of stored blocks
+	std::vector<unsigned char> zlib;
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	size_t pos = 0;
+	do
+	{
+		size_t len = std::min(raw.size() - pos, (size_t) 65535);
+		zlib.push_back(pos + len == raw.size() ? 1 : 0);
+		zlib.push_back((unsigned char) (len & 0xFF));
+		zlib.push_back((unsigned char) (len >> 8));
+		zlib.push_back((unsigned char) (~len & 0xFF));
+		zlib.push_back((unsigned char) ((~len >> 8) & 0xFF));
+		zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+		pos += len;
+	} while(pos < raw.size());
+	unsigned int a = 1;
+	unsigned int b = 0;
+	for(size_t i = 0; i < raw.size(); i++)
+	{
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_be32(zlib, (b << 16) | a);
+	write_chunk(file, "IDAT", zlib);
+	write_chunk(file, "IEND", std::vector<unsigned char>());
+	return fclose(file) == 0;
+}
+
+void container_raster::draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos)
+{
+	container_metrics::draw_text(hdc, text, hFont, color, pos);
+	paint_text(text, hFont, color, pos);
+}
+
+void container_raster::draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color)
+{
+	container_metrics::draw_text_run(hdc, texts, positions, count, hFont, color);
+	for(int i = 0; i < count; i++)
+	{
+		paint_text(texts[i], hFont, color, positions[i]);
+	}
+}
+
+void container_raster::draw_background(litehtml::uint_ptr hdc, const litehtml::background_paint& bg)
+{
+	container_metrics::draw_background(hdc, bg);
+	if(bg.color.alpha)
+	{
+		fill_rounded_rect(bg.clip_box, bg.border_box, bg.border_radius, bg.color);
+	}
+}
+
+void container_raster::draw_borders(litehtml::uint_ptr hdc, const litehtml::borders& borders, const litehtml::position& draw_pos, bool root)
+{
+	container_metrics::draw_borders(hdc, borders, draw_pos, root);
+
+	litehtml::position inner = draw_pos;
+	inner.x			+= borders.left.width;
+	inner.y			+= borders.top.width;
+	inner.width		-= borders.left.width + borders.right.width;
+	inner.height	-= borders.top.width + borders.bottom.width;
+	litehtml::border_radiuses inner_radius;
+	inner_radius.top_left_x		= std::max(borders.radius.top_left_x - borders.left.width, 0);
+	inner_radius.top_left_y		= std::max(borders.radius.top_left_y - borders.top.width, 0);
+	inner_radius.top_right_x	= std::max(borders.radius.top_right_x - borders.right.width, 0);
+	inner_radius.top_right_y	= std::max(borders.radius.top_right_y - borders.top.width, 0);
+	inner_radius.bottom_right_x	= std::max(borders.radius.bottom_right_x - borders.right.width, 0);
+	inner_radius.bottom_right_y	= std::max(borders.radius.bottom_right_y - borders.bottom.width, 0);
+	inner_radius.bottom_left_x	= std::max(borders.radius.bottom_left_x - borders.left.width, 0);
+	inner_radius.bottom_left_y	= std::max(borders.radius.bottom_left_y - borders.bottom.width, 0);
+
+	int left	= std::max(draw_pos.left(), m_clip_rect.left());
+	int top		= std::max(draw_pos.top(), m_clip_rect.top());
+	int right	= std::min(draw_pos.right(), m_clip_rect.right());
+	int bottom	= std::min(draw_pos.bottom(), m_clip_rect.bottom());
+	for(int y = top; y < bottom; y++)
+	{
+		for(int x = left; x < right; x++)
+		{
+			double cx = x + 0.5;
+			double cy = y + 0.5;
+			if(!inside_rounded(cx, cy, draw_pos, borders.radius) || inside_rounded(cx, cy, inner, inner_radius) || is_clipped(x, y))
+			{
+				continue;
+			}
+			// the pixel belongs to the side it is relatively closest to, which splits the corners diagonally
+			const litehtml::border* brd = 0;
+			double depth = 0;
+			double best = 0;
+			int along = 0;
+			const litehtml::border* sides[4]	= { &borders.top, &borders.bottom, &borders.left, &borders.right };
+			double depths[4]					= { cy - draw_pos.top(), draw_pos.bottom() - cy, cx - draw_pos.left(), draw_pos.right() - cx };
+			int alongs[4]						= { x - draw_pos.left(), x - draw_pos.left(), y - draw_pos.top(), y - draw_pos.top() };
+			for(int side = 0; side < 4; side++)
+			{
+				if(sides[side]->width > 0)
+				{
+					double ratio = depths[side] / sides[side]->width;
+					if(!brd || ratio < best)
+					{
+						brd		= sides[side];
+						best	= ratio;
+						depth	= depths[side];
+						along	= alongs[side];
+					}
+				}
+			}
+			if(brd && border_pixel(*brd, depth, along))
+			{
+				blend(x, y, brd->color);
+			}
+		}
+	}
+}
+
+void container_raster::draw_list_marker(litehtml::uint_ptr hdc, const litehtml::list_marker& marker)
+{
+	container_metrics::draw_list_marker(hdc, marker);
+	switch(marker.marker_type)
+	{
+	case litehtml::list_style_type_circle:
+		draw_ellipse(marker.pos, marker.color, false);
+		break;
+	case litehtml::list_style_type_disc:
+		draw_ellipse(marker.pos, marker.color, true);
+		break;
+	case litehtml::list_style_type_square:
+		fill_rect(marker.pos.left(), marker.pos.top(), marker.pos.right(), marker.pos.bottom(), marker.color);
+		break;
+	default:
+		break;
+	}
+}
+
+void container_raster::set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y)
+{
+	container_metrics::set_clip(pos, bdr_radius, valid_x, valid_y);
+	clip_box clip;
+	clip.pos		= pos;
+	clip.radius		= bdr_radius;
+	clip.valid_x	= valid_x;
+	clip.valid_y	= valid_y;
+	m_clips.push_back(clip);
+	update_clip_rect();
+}
+
+void container_raster::del_clip()
+{
+	container_metrics::del_clip();
+	if(!m_clips.empty())
+	{
+		m_clips.pop_back();
+	}
+	update_clip_rect();
+}
+
+void container_raster::update_clip_rect()
+{
+	int left	= 0;
+	int top		= 0;
+	int right	= m_width;
+	int bottom	= m_height;
+	m_rounded_clip = false;
+	for(const auto& clip : m_clips)
+	{
+		if(clip.valid_x)
+		{
+			left	= std::max(left, clip.pos.left());
+			right	= std::min(right, clip.pos.right());
+		}
+		if(clip.valid_y)
+		{
+			top		= std::max(top, clip.pos.top());
+			bottom	= std::min(bottom, clip.pos.bottom());
+		}
+		if(clip.valid_x && clip.valid_y && has_radius(clip.radius))
+		{
+			m_rounded_clip = true;
+		}
+	}
+	m_clip_rect = litehtml::position(left, top, std::max(right - left, 0), std::max(bottom - top, 0));
+}
+
+bool container_raster::is_clipped(int x, int y) const
+{
+	if(!m_rounded_clip)
+	{
+		return false;
+	}
+	for(const auto& clip : m_clips)
+	{
+		if(clip.valid_x && clip.valid_y && !inside_rounded(x + 0.5, y + 0.5, clip.pos, clip.radius))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void container_raster::blend(int x, int y, litehtml::web_color color)
+{
+	unsigned char* px = &m_pixels[((size_t) y * m_width + x) * 4];
+	if(color.alpha == 0xFF)
+	{
+		px[0] = color.red;
+		px[1] = color.green;
+		px[2] = color.blue;
+		px[3] = 0xFF;
+	} else if(color.alpha)
+	{
+		int a = color.alpha;
+		px[0] = (unsigned char) ((color.red * a + px[0] * (255 - a) + 127) / 255);
+		px[1] = (unsigned char) ((color.green * a + px[1] * (255 - a) + 127) / 255);
+		px[2] = (unsigned char) ((color.blue * a + px[2] * (255 - a) + 127) / 255);
+		px[3] = (unsigned char) (a + (px[3] * (255 - a) + 127) / 255);
+	}
+}
+
+void container_raster::fill_rect(int left, int top, int right, int bottom, litehtml::web_color color)
+{
+	left	= std::max(left, m_clip_rect.left());
+	top		= std::max(top, m_clip_rect.top());
+	right	= std::min(right, m_clip_rect.right());
+	bottom	= std::min(bottom, m_clip_rect.bottom());
+	for(int y = top; y < bottom; y++)
+	{
+		for(int x = left; x < right; x++)
+		{
+			if(!is_clipped(x, y))
+			{
+				blend(x, y, color);
+			}
+		}
+	}
+}
+
+void container_raster::fill_rounded_rect(const litehtml::position& area, const litehtml::position& box, const litehtml::border_radiuses& radius, litehtml::web_color color)
+{
+	if(!has_radius(radius))
+	{
+		fill_rect(area.left(), area.top(), area.right(), area.bottom(), color);
+		return;
+	}
+	int left	= std::max(area.left(), m_clip_rect.left());
+	int top		= std::max(area.top(), m_clip_rect.top());
+	int right	= std::min(area.right(), m_clip_rect.right());
+	int bottom	= std::min(area.bottom(), m_clip_rect.bottom());
+	for(int y = top; y < bottom; y++)
+	{
+		for(int x = left; x < right; x++)
+		{
+			if(inside_rounded(x + 0.5, y + 0.5, box, radius) && !is_clipped(x, y))
+			{
+				blend(x, y, color);
+			}
+		}
+	}
+}
+
+void container_raster::draw_ellipse(const litehtml::position& pos, litehtml::web_color color, bool fill)
+{
+	if(pos.width <= 0 || pos.height <= 0)
+	{
+		return;
+	}
+	double rx = pos.width / 2.0;
+	double ry = pos.height / 2.0;
+	double cx = pos.x + rx;
+	double cy = pos.y + ry;
+	int left	= std::max(pos.left(), m_clip_rect.left());
+	int top		= std::max(pos.top(), m_clip_rect.top());
+	int right	= std::min(pos.right(), m_clip_rect.right());
+	int bottom	= std::min(pos.bottom(), m_clip_rect.bottom());
+	for(int y = top; y < bottom; y++)
+	{
+		for(int x = left; x < right; x++)
+		{
+			double dx = (x + 0.5 - cx) / rx;
+			double dy = (y + 0.5 - cy) / ry;
+			if(dx * dx + dy * dy > 1.0)
+			{
+				continue;
+			}
+			if(!fill && rx > 1 && ry > 1)
+			{
+				// the ring is one pixel wide
+				double ix = (x + 0.5 - cx) / (rx - 1);
+				double iy = (y + 0.5 - cy) / (ry - 1);
+				if(ix * ix + iy * iy < 1.0)
+				{
+					continue;
+				}
+			}
+			if(!is_clipped(x, y))
+			{
+				blend(x, y, color);
+			}
+		}
+	}
+}
+
+void container_raster::paint_text(const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos)
+{
+	if(!text || !hFont || hFont > m_fonts.size())
+	{
+		return;
+	}
+	const font& fnt = m_fonts[hFont - 1];
+	bool bold = fnt.weight >= 600 && !fnt.monospace;
+
+	// the seven glyph rows make the cap height of 0.7 em and sit on the baseline of container_metrics
+	double row		= fnt.size / 10.0;
+	double column	= row * 0.8;
+	int baseline	= pos.bottom() - (fnt.size - fnt.size * 4 / 5);
+	long long advance = 0;
+	for(const litehtml::tchar_t* str = text; *str;)
+	{
+		unsigned int ch = next_char(str);
+		int ch_advance = char_advance(fnt, ch);
+		if(!ch_advance)
+		{
+			continue;
+		}
+		double cell_x	= pos.x + (double) advance * fnt.size / 1000.0 * (bold ? 1.05 : 1.0);
+		double cell_w	= (double) ch_advance * fnt.size / 1000.0;
+		double glyph_x	= cell_x + std::max((cell_w - column * 5) / 2, 0.0);
+		advance += ch_advance;
+
+		if(ch >= 0x21 && ch < 0x7F)
+		{
+			const unsigned char* glyph = glyphs_5x7[ch - 0x20];
+			for(int col = 0; col < 5; col++)
+			{
+				int x0 = (int) floor(glyph_x + col * column);
+				int x1 = std::max((int) floor(glyph_x + (col + 1) * column), x0 + 1) + (bold ? 1 : 0);
+				for(int r = 0; r < 7; r++)
+				{
+					if(glyph[col] & (1 << r))
+					{
+						int y0 = (int) floor(baseline - (7 - r) * row);
+						int y1 = std::max((int) floor(baseline - (6 - r) * row), y0 + 1);
+						fill_rect(x0, y0, x1, y1, color);
+					}
+				}
+			}
+		} else if(ch > 0x20)
+		{
+			// a box for the characters without a glyph
+			int x0 = (int) floor(glyph_x);
+			int x1 = std::max((int) floor(cell_x + cell_w - (glyph_x - cell_x)), x0 + 2);
+			int y0 = (int) floor(baseline - 7 * row);
+			fill_rect(x0, y0, x1, y0 + 1, color);
+			fill_rect(x0, baseline - 1, x1, baseline, color);
+			fill_rect(x0, y0, x0 + 1, baseline, color);
+			fill_rect(x1 - 1, y0, x1, baseline, color);
+		}
+	}
+
+	if(fnt.decoration)
+	{
+		int thickness = std::max(fnt.size / 16, 1);
+		int right = pos.x + (int) ((advance * fnt.size * (bold ? 105 : 100) / 100 + 500) / 1000);
+		if(fnt.decoration & litehtml::font_decoration_underline)
+		{
+			int y = baseline + (int) ceil(row);
+			fill_rect(pos.x, y, right, y + thickness, color);
+		}
+		if(fnt.decoration & litehtml::font_decoration_linethrough)
+		{
+			int y = (int) floor(baseline - 3.5 * row);
+			fill_rect(pos.x, y, right, y + thickness, color);
+		}
+		if(fnt.decoration & litehtml::font_decoration_overline)
+		{
+			int y = (int) floor(baseline - 8 * row);
+			fill_rect(pos.x, y, right, y + thickness, color);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef LH_CONTAINER_RASTER_H
+#define LH_CONTAINER_RASTER_H
+
+#include "../metrics/container_metrics.h"
+#include <vector>
+
+// headless container that paints into an RGBA buffer, with the synthetic metrics of container_metrics
+// and a built-in 5x7 bitmap font; images are not decoded, so only their boxes take space
+class container_raster : public container_metrics
+{
+	struct clip_box
+	{
+		litehtml::position			pos;
+		litehtml::border_radiuses	radius;
+		bool						valid_x;
+		bool						valid_y;
+	};
+
+	std::vector<unsigned char>	m_pixels;
+	int							m_width;
+	int							m_height;
+	std::vector<clip_box>		m_clips;
+	litehtml::position			m_clip_rect;		// the clips intersected, without the radiuses
+	bool						m_rounded_clip;
+
+public:
+	container_raster(int width, int height);
+	virtual ~container_raster();
+
+	// also sets the client size, the pixels are cleared to white
+	void						resize(int width, int height);
+	void						clear(litehtml::web_color color);
+	int							width() const;
+	int							height() const;
+	// rows of RGBA pixels from the top
+	const unsigned char*		pixels() const;
+	litehtml::web_color			pixel(int x, int y) const;
+	// the number of pixels that differ by more than tolerance in any channel, -1 for a size mismatch
+	int							compare(const container_raster& other, int tolerance = 0) const;
+
+	bool						write_ppm(const char* path) const;
+	// uncompressed deflate blocks, so no zlib is needed
+	bool						write_png(const char* path) const;
+	bool						read_ppm(const char* path);
+
+	virtual void						draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) override;
+	virtual void						draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color) override;
+	virtual void						draw_background(litehtml::uint_ptr hdc, const litehtml::background_paint& bg) override;
+	virtual void						draw_borders(litehtml::uint_ptr hdc, const litehtml::borders& borders, const litehtml::position& draw_pos, bool root) override;
+	virtual void						draw_list_marker(litehtml::uint_ptr hdc, const litehtml::list_marker& marker) override;
+	virtual void						set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y) override;
+	virtual void						del_clip() override;
+
+private:
+	void						update_clip_rect();
+	bool						is_clipped(int x, int y) const;
+	void						blend(int x, int y, litehtml::web_color color);
+	void						fill_rect(int left, int top, int right, int bottom, litehtml::web_color color);
+	void						fill_rounded_rect(const litehtml::position& area, const litehtml::position& box, const litehtml::border_radiuses& radius, litehtml::web_color color);
+	void						draw_ellipse(const litehtml::position& pos, litehtml::web_color color, bool fill);
+	void						paint_text(const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos);
+};
+
+inline int container_raster::width() const
+{
+	return m_width;
+}
+
+inline int container_raster::height() const
+{
+	return m_height;
+}
+
+inline const unsigned char* container_raster::pixels() const
+{
+	return m_pixels.empty() ? 0 : &m_pixels[0];
+}
+
+#endif  // LH_CONTAINER_RASTER_H
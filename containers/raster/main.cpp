@@ -0,0 +1,154 @@
+#include "container_raster.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+extern const litehtml::tchar_t master_css[] =
+{
+#include "master.css.inc"
+,0
+};
+
+static long long now_ns()
+{
+	return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool read_file(const char* path, std::string& text)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file)
+	{
+		return false;
+	}
+	char buf[4096];
+	size_t len;
+	while((len = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		text.append(buf, len);
+	}
+	fclose(file);
+	return true;
+}
+
+static bool ends_with(const char* str, const char* suffix)
+{
+	size_t len = strlen(str);
+	size_t suffix_len = strlen(suffix);
+	return len >= suffix_len && !strcmp(str + len - suffix_len, suffix);
+}
+
+static int usage()
+{
+	fprintf(stderr,
+		"usage: litehtml_raster [options] input.html [output.png|output.ppm]\n"
+		"  --width N        layout width, 800 by default\n"
+		"  --height N       image height, the document height by default\n"
+		"  --repeat N       paint N times and report the fastest, 1 by default\n"
+		"  --compare FILE   count the pixels that differ from a PPM image\n"
+		"  --tolerance N    channel difference ignored by --compare, 0 by default\n"
+		"  --max-diff N     fail when more than N pixels differ, 0 by default\n");
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	int width		= 800;
+	int height		= 0;
+	int repeat		= 1;
+	int tolerance	= 0;
+	int max_diff	= 0;
+	const char* input	= 0;
+	const char* output	= 0;
+	const char* golden	= 0;
+	for(int i = 1; i < argc; i++)
+	{
+		bool has_value = i + 1 < argc;
+		if(!strcmp(argv[i], "--width") && has_value)			width		= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--height") && has_value)		height		= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--repeat") && has_value)		repeat		= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--compare") && has_value)		golden		= argv[++i];
+		else if(!strcmp(argv[i], "--tolerance") && has_value)	tolerance	= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--max-diff") && has_value)	max_diff	= atoi(argv[++i]);
+		else if(argv[i][0] == '-')								return usage();
+		else if(!input)											input		= argv[i];
+		else if(!output)										output		= argv[i];
+		else													return usage();
+	}
+	if(!input || width <= 0)
+	{
+		return usage();
+	}
+
+	std::string html;
+	if(!read_file(input, html))
+	{
+		fprintf(stderr, "can't read %s\n", input);
+		return 1;
+	}
+
+	container_raster container(width, height > 0 ? height : 600);
+	litehtml::context ctx;
+	ctx.load_master_stylesheet(master_css);
+
+	long long start = now_ns();
+	litehtml::document::ptr doc = litehtml::document::createFromUTF8(html.c_str(), &container, &ctx);
+	long long create_ns = now_ns() - start;
+	start = now_ns();
+	doc->render(width);
+	long long render_ns = now_ns() - start;
+	if(height <= 0)
+	{
+		container.resize(width, std::max(doc->height(), 1));
+	}
+
+	// every paint starts from a white page, the fastest one is reported
+	litehtml::position clip(0, 0, container.width(), container.height());
+	long long draw_ns = 0;
+	for(int i = 0; i < std::max(repeat, 1); i++)
+	{
+		container.clear(litehtml::web_color(255, 255, 255));
+		container.reset_counts();
+		start = now_ns();
+		doc->draw((litehtml::uint_ptr) 0, 0, 0, &clip);
+		long long ns = now_ns() - start;
+		if(!i || ns < draw_ns)
+		{
+			draw_ns = ns;
+		}
+	}
+
+	int diff = 0;
+	if(golden)
+	{
+		container_raster expected(0, 0);
+		if(!expected.read_ppm(golden))
+		{
+			fprintf(stderr, "can't read %s\n", golden);
+			return 1;
+		}
+		diff = container.compare(expected, tolerance);
+	}
+	if(output)
+	{
+		bool written = ends_with(output, ".ppm") ? container.write_ppm(output) : container.write_png(output);
+		if(!written)
+		{
+			fprintf(stderr, "can't write %s\n", output);
+			return 1;
+		}
+	}
+
+	double pixels = (double) container.width() * container.height();
+	printf("{\n  \"width\": %d,\n  \"height\": %d,\n  \"create_ns\": %lld,\n  \"render_ns\": %lld,\n  \"draw_ns\": %lld,\n  \"draw_calls\": %d,\n  \"megapixels_per_s\": %.2f",
+		container.width(), container.height(), create_ns, render_ns, draw_ns, container.counts().total(), draw_ns ? pixels / 1e6 / (draw_ns / 1e9) : 0.0);
+	if(golden)
+	{
+		printf(",\n  \"diff_pixels\": %d", diff);
+	}
+	printf("\n}\n");
+	return golden && (diff < 0 || diff > max_diff) ? 1 : 0;
+}
@@ -47,6 +47,11 @@ namespace litehtml
 		virtual int					bottom_margin() = 0;
 		virtual void				y_shift(int shift) = 0;
 		virtual void				new_width(int left, int right, elements_vector& els) = 0;
+		virtual void				get_right_range(int& min_right, int& max_right) = 0;
+		virtual void				set_right(int right) = 0;
+		virtual size_t				memory_size() = 0;
+		// drops the elements but keeps the storage, the box waits in html_tag::m_spare_boxes for reuse
+		virtual void				clear_elements() = 0;
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -60,6 +65,14 @@ namespace litehtml
 			m_element = 0;
 		}
 
+		void reset(int top, int left, int right)
+		{
+			m_box_top	= top;
+			m_box_left	= left;
+			m_box_right	= right;
+			m_element	= 0;
+		}
+
 		virtual litehtml::box_type	get_type();
 		virtual int					height();
 		virtual int					width();
@@ -73,6 +86,10 @@ namespace litehtml
 		virtual int					bottom_margin();
 		virtual void				y_shift(int shift);
 		virtual void				new_width(int left, int right, elements_vector& els);
+		virtual void				get_right_range(int& min_right, int& max_right);
+		virtual void				set_right(int right);
+		virtual size_t				memory_size();
+		virtual void				clear_elements();
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -86,6 +103,9 @@ namespace litehtml
 		font_metrics			m_font_metrics;
 		int						m_baseline;
 		text_align				m_text_align;
+		int						m_align_shift;
+		int						m_min_right;	// the line breaks stay the same while
+		int						m_max_right;	// m_min_right <= m_box_right <= m_max_right
 	public:
 		line_box(int top, int left, int right, int line_height, font_metrics& fm, text_align align) : box(top, left, right)
 		{
@@ -95,6 +115,26 @@ namespace litehtml
 			m_line_height	= line_height;
 			m_baseline		= 0;
 			m_text_align	= align;
+			m_align_shift	= 0;
+			m_min_right		= 0;
+			m_max_right		= INT_MAX;
+		}
+
+		void reset(int top, int left, int right, int line_height, font_metrics& fm, text_align align)
+		{
+			m_box_top		= top;
+			m_box_left		= left;
+			m_box_right		= right;
+			m_items.clear();
+			m_height		= 0;
+			m_width			= 0;
+			m_font_metrics	= fm;
+			m_line_height	= line_height;
+			m_baseline		= 0;
+			m_text_align	= align;
+			m_align_shift	= 0;
+			m_min_right		= 0;
+			m_max_right		= INT_MAX;
 		}
 
 		virtual litehtml::box_type	get_type();
@@ -110,10 +150,15 @@ namespace litehtml
 		virtual int					bottom_margin();
 		virtual void				y_shift(int shift);
 		virtual void				new_width(int left, int right, elements_vector& els);
+		virtual void				get_right_range(int& min_right, int& max_right);
+		virtual void				set_right(int right);
+		virtual size_t				memory_size();
+		virtual void				clear_elements();
 
 	private:
 		bool						have_last_space();
 		bool						is_break_only();
+		int							calc_align_shift();
 	};
 }
 
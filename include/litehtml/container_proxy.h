@@ -0,0 +1,54 @@
+#ifndef LH_CONTAINER_PROXY_H
+#define LH_CONTAINER_PROXY_H
+
+#include "html.h"
+
+namespace litehtml
+{
+	// forwards every call to another container; derive from it to intercept some of the calls
+	class container_proxy : public document_container
+	{
+	protected:
+		document_container*	m_target;
+	public:
+		container_proxy(document_container* target);
+
+		document_container*					target() const;
+
+		virtual uint_ptr					create_font(const tchar_t* faceName, int size, int weight, font_style italic, unsigned int decoration, font_metrics* fm) override;
+		virtual void						delete_font(uint_ptr hFont) override;
+		virtual int							text_width(const tchar_t* text, uint_ptr hFont) override;
+		virtual void						text_widths(const tchar_t* const* texts, int count, uint_ptr hFont, int* widths) override;
+		virtual void						draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos) override;
+		virtual void						draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color) override;
+		virtual int							pt_to_px(int pt) override;
+		virtual int							get_default_font_size() const override;
+		virtual const tchar_t*				get_default_font_name() const override;
+		virtual void						draw_list_marker(uint_ptr hdc, const list_marker& marker) override;
+		virtual void						load_image(const tchar_t* src, const tchar_t* baseurl, bool redraw_on_ready) override;
+		virtual void						get_image_size(const tchar_t* src, const tchar_t* baseurl, size& sz) override;
+		virtual void						draw_background(uint_ptr hdc, const background_paint& bg) override;
+		virtual void						draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root) override;
+		virtual void						set_caption(const tchar_t* caption) override;
+		virtual void						set_base_url(const tchar_t* base_url) override;
+		virtual void						link(const std::shared_ptr<document>& doc, const element::ptr& el) override;
+		virtual void						on_anchor_click(const tchar_t* url, const element::ptr& el) override;
+		virtual void						set_cursor(const tchar_t* cursor) override;
+		virtual void						transform_text(tstring& text, text_transform tt) override;
+		virtual void						import_css(tstring& text, const tstring& url, tstring& baseurl) override;
+		virtual void						set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y) override;
+		virtual void						del_clip() override;
+		virtual void						get_client_rect(position& client) const override;
+		virtual std::shared_ptr<element>	create_element(const tchar_t* tag_name, const string_map& attributes, const std::shared_ptr<document>& doc) override;
+		virtual void						get_media_features(media_features& media) const override;
+		virtual void						get_language(tstring& language, tstring& culture) const override;
+		virtual tstring						resolve_color(const tstring& color) const override;
+	};
+
+	inline document_container* container_proxy::target() const
+	{
+		return m_target;
+	}
+}
+
+#endif  // LH_CONTAINER_PROXY_H
@@ -2,18 +2,53 @@
 #define LH_CONTEXT_H
 
 #include "stylesheet.h"
+#include "trace.h"
 
 namespace litehtml
 {
 	class context
 	{
 		litehtml::css	m_master_css;
+		bool			m_collect_stats;
+		bool			m_profile_selectors;
+		tracer::ptr		m_tracer;
 	public:
+		context() : m_collect_stats(false), m_profile_selectors(false)
+		{
+		}
+
 		void			load_master_stylesheet(const tchar_t* str);
 		litehtml::css&	master_css()
 		{
 			return m_master_css;
 		}
+		// documents created with this context collect document_stats from the start
+		void			set_collect_stats(bool enable)
+		{
+			m_collect_stats = enable;
+		}
+		bool			collect_stats() const
+		{
+			return m_collect_stats;
+		}
+		// documents created with this context profile their selectors from the first cascade
+		void			set_profile_selectors(bool enable)
+		{
+			m_profile_selectors = enable;
+		}
+		bool			profile_selectors() const
+		{
+			return m_profile_selectors;
+		}
+		// documents created with this context write their spans to the tracer, null disables tracing
+		void			set_tracer(const tracer::ptr& tr)
+		{
+			m_tracer = tr;
+		}
+		const tracer::ptr&	get_tracer() const
+		{
+			return m_tracer;
+		}
 	};
 }
 
@@ -182,6 +182,10 @@ namespace litehtml
 		style::ptr				m_style;
 		int						m_order;
 		media_query_list::ptr	m_media_query;
+#ifndef LITEHTML_NO_STATS
+		tstring					m_source;		// the selector text, for the selector profile
+		tstring					m_origin;		// base url of the style sheet
+#endif
 	public:
 		css_selector(media_query_list::ptr media)
 		{
@@ -208,10 +212,16 @@ namespace litehtml
 			m_specificity	= val.m_specificity;
 			m_order			= val.m_order;
 			m_media_query	= val.m_media_query;
+#ifndef LITEHTML_NO_STATS
+			m_source		= val.m_source;
+			m_origin		= val.m_origin;
+#endif
 		}
 
 		bool parse(const tstring& text);
 		void calc_specificity();
+		// the selector with its left parts, the style is not included
+		size_t memory_size() const;
 		bool is_media_valid() const;
 		void add_media_to_doc(document* doc) const;
 	};
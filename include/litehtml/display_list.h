@@ -0,0 +1,78 @@
+#ifndef LH_DISPLAY_LIST_H
+#define LH_DISPLAY_LIST_H
+
+#include <functional>
+#include "types.h"
+#include "background.h"
+#include "borders.h"
+
+namespace litehtml
+{
+	class document_container;
+
+	enum display_item_type
+	{
+		display_item_text,
+		display_item_background,
+		display_item_borders,
+		display_item_list_marker,
+		display_item_set_clip,
+		display_item_del_clip,
+	};
+
+	struct display_item
+	{
+		display_item_type	type;
+		position			pos;		// text run, borders, list marker or clip box
+		int					index;		// text, background, borders or radius index
+		int					end;		// the matching del_clip of set_clip, the number of texts in a text run
+		uint_ptr			font;
+		web_color			color;
+		int					flags;		// root borders, clip valid_x/valid_y, list marker type
+	};
+
+	// the paint calls of a document in paint order, recorded once and replayed on every draw
+	class display_list
+	{
+		std::vector<display_item>		m_items;
+		std::vector<tstring>			m_texts;
+		std::vector<position>			m_text_positions;
+		std::vector<background_paint>	m_backgrounds;
+		std::vector<borders>			m_borders;
+		std::vector<border_radiuses>	m_radiuses;
+		std::vector<int>				m_open_clips;
+		bool							m_valid;
+	public:
+		display_list();
+
+		// calls draw with a container that records the paint calls and forwards the rest to target
+		void	record(document_container* target, const std::function<void(document_container*)>& draw);
+		// the container must understand the font handles of the recording one
+		void	replay(document_container* container, uint_ptr hdc, int x, int y, const position* clip) const;
+		void	clear();
+		bool	is_valid() const;
+		size_t	size() const;
+
+		void	add_text(const tchar_t* text, uint_ptr font, web_color color, const position& pos);
+		void	add_background(const background_paint& bg);
+		void	add_borders(const borders& brd, const position& draw_pos, bool root);
+		void	add_list_marker(const tstring& image, const tchar_t* baseurl, list_style_type marker_type, web_color color, const position& pos);
+		void	add_set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y);
+		void	add_del_clip();
+
+	private:
+		display_item& add_item(display_item_type type, const position& pos, int index);
+	};
+
+	inline bool display_list::is_valid() const
+	{
+		return m_valid;
+	}
+
+	inline size_t display_list::size() const
+	{
+		return m_items.size();
+	}
+}
+
+#endif  // LH_DISPLAY_LIST_H
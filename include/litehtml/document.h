@@ -4,6 +4,9 @@
 #include "style.h"
 #include "types.h"
 #include "context.h"
+#include "executor.h"
+#include "display_list.h"
+#include "stats.h"
 
 namespace litehtml
 {
@@ -63,12 +66,33 @@ namespace litehtml
 		litehtml::context*					m_context;
 		litehtml::size						m_size;
 		position::vector					m_fixed_boxes;
+		int									m_scroll_x;
+		int									m_scroll_y;
 		media_query_list::vector			m_media_lists;
 		element::ptr						m_over_element;
 		elements_vector						m_tabular_elements;
 		media_features						m_media;
 		tstring                             m_lang;
 		tstring                             m_culture;
+		bool								m_lazy_layout;
+		bool								m_defer_layout;
+		int									m_defer_bottom;
+		elements_vector						m_pending_layout;
+		executor::ptr						m_executor;
+		std::mutex							m_container_lock;
+		bool								m_record_display_list;
+		display_list						m_display_list;
+		int									m_display_list_width;	// the render width of the recorded layout
+		document_stats						m_stats;
+		bool								m_collect_stats;
+		selector_profile					m_selector_profile;
+		bool								m_profile_selectors;
+		tracer::ptr							m_tracer;
+		std::unique_ptr<tracing_container>	m_tracing_container;	// in front of the container while tracing
+		bool								m_track_damage;
+		std::vector<std::pair<const element*, position>>	m_damage_boxes;	// painted box of every element after the last render
+		position::vector					m_damage;
+		bool								m_hit_index;
 	public:
 		document(litehtml::document_container* objContainer, litehtml::context* ctx);
 		virtual ~document();
@@ -91,12 +115,44 @@ namespace litehtml
 		element::ptr					root();
 		void							get_fixed_boxes(position::vector& fixed_boxes);
 		void							add_fixed_box(const position& pos);
+		bool							scroll_to(int x, int y, position::vector& redraw_boxes);
 		void							add_media_list(media_query_list::ptr list);
 		bool							media_changed();
 		bool							lang_changed();
 		bool                            match_lang(const tstring & lang);
 		void							add_tabular(const element::ptr& el);
 		const element::const_ptr		get_over_element() const { return m_over_element; }
+		void							set_lazy_layout(bool enable);
+		bool							realize_layout(const position* rect = 0);
+		bool							is_layout_deferred() const;
+		bool							can_defer_layout(int top) const;
+		void							add_pending_layout(const element::ptr& el);
+		void							set_executor(const executor::ptr& exec);
+		void							run_tasks(int count, const std::function<void(int)>& task);
+		// a lambda with many captures is wrapped by reference, so it does not allocate a std::function
+		template<typename Task>
+		void							run_tasks(int count, const Task& task)
+		{
+			run_tasks(count, std::function<void(int)>(std::cref(task)));
+		}
+		std::unique_lock<std::mutex>	lock_container();
+		// the list is recorded by the first draw after a layout or style change and replayed until the next one
+		void							set_record_display_list(bool enable);
+		const display_list&				get_display_list() const;
+		// for changes the document can't see, like a modified tree or a loaded image
+		void							invalidate_display_list();
+		const document_timings&			get_timings() const;
+		const document_stats&			stats() const;
+		void							set_collect_stats(bool enable);
+		const selector_profile&			get_selector_profile() const;
+		void							set_profile_selectors(bool enable);
+		litehtml::memory_usage			memory_usage() const;
+		void							set_tracer(const tracer::ptr& tr);
+		void							set_track_damage(bool enable);
+		void							take_damage(position::vector& damage);
+		// the row index of the children of large elements, built by the next render
+		void							set_hit_index(bool enable);
+		bool							use_hit_index() const;
 
 		static litehtml::document::ptr createFromString(const tchar_t* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
 		static litehtml::document::ptr createFromUTF8(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles = 0);
@@ -106,6 +162,11 @@ namespace litehtml
 
 		void create_node(void* gnode, elements_vector& elements, bool parseTextNode);
 		bool update_media_lists(const media_features& features);
+		void record_display_list();
+		bool find_styles_changes(position::vector& redraw_boxes);
+		void update_damage(const litehtml::size& old_size);
+		void get_damage_boxes(const element::ptr& el, int x, int y, std::vector<std::pair<const element*, position>>& boxes);
+		void add_damage(const position& pos);
 		void fix_tables_layout();
 		void fix_table_children(element::ptr& el_ptr, style_display disp, const tchar_t* disp_str);
 		void fix_table_parent(element::ptr& el_ptr, style_display disp, const tchar_t* disp_str);
@@ -119,6 +180,78 @@ namespace litehtml
 	{
 		m_tabular_elements.push_back(el);
 	}
+	inline void document::set_lazy_layout(bool enable)
+	{
+		m_lazy_layout = enable;
+	}
+	inline bool document::is_layout_deferred() const
+	{
+		return m_defer_layout;
+	}
+	inline bool document::can_defer_layout(int top) const
+	{
+		return m_defer_layout && top > m_defer_bottom;
+	}
+	inline void document::add_pending_layout(const element::ptr& el)
+	{
+		m_pending_layout.push_back(el);
+	}
+	inline void document::set_executor(const executor::ptr& exec)
+	{
+		m_executor = exec;
+	}
+	inline void document::set_record_display_list(bool enable)
+	{
+		m_record_display_list = enable;
+		m_display_list.clear();
+	}
+	inline const display_list& document::get_display_list() const
+	{
+		return m_display_list;
+	}
+	inline void document::invalidate_display_list()
+	{
+		m_display_list.clear();
+	}
+	inline const document_timings& document::get_timings() const
+	{
+		return m_stats.creation;
+	}
+	inline const document_stats& document::stats() const
+	{
+		return m_stats;
+	}
+	inline void document::set_collect_stats(bool enable)
+	{
+		m_collect_stats = enable;
+	}
+	inline const selector_profile& document::get_selector_profile() const
+	{
+		return m_selector_profile;
+	}
+	inline void document::set_profile_selectors(bool enable)
+	{
+		m_profile_selectors = enable;
+	}
+	inline void document::set_track_damage(bool enable)
+	{
+		m_track_damage = enable;
+		m_damage_boxes.clear();
+		m_damage.clear();
+	}
+	inline void document::set_hit_index(bool enable)
+	{
+		m_hit_index = enable;
+	}
+	inline bool document::use_hit_index() const
+	{
+		return m_hit_index;
+	}
+	inline std::unique_lock<std::mutex> document::lock_container()
+	{
+		// layout tasks may run on several threads and share the container
+		return std::unique_lock<std::mutex>(m_container_lock);
+	}
 	inline bool document::match_lang(const tstring & lang)
 	{
 		return lang == m_lang || lang == m_culture;
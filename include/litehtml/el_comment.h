@@ -14,6 +14,7 @@ namespace litehtml
 
 		virtual void	get_text(tstring& text) override;
 		virtual void	set_data(const tchar_t* data) override;
+		virtual void	add_memory_usage(memory_usage& usage) const override;
 	};
 }
 
@@ -20,6 +20,7 @@ namespace litehtml
 		virtual void	parse_styles(bool is_reparse = false) override;
 		virtual void	draw(uint_ptr hdc, int x, int y, const position* clip) override;
 		virtual void	get_content_size(size& sz, int max_width) override;
+		virtual void	add_memory_usage(memory_usage& usage) const override;
 	private:
 		int calc_max_height(int image_height);
 	};
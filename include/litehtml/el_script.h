@@ -15,6 +15,7 @@ namespace litehtml
 		virtual void			parse_attributes() override;
 		virtual bool			appendChild(const ptr &el) override;
 		virtual const tchar_t*	get_tagName() const override;
+		virtual void			add_memory_usage(memory_usage& usage) const override;
 	};
 }
 
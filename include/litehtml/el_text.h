@@ -19,6 +19,8 @@ namespace litehtml
 		virtual ~el_text();
 
 		virtual void				get_text(tstring& text) override;
+		virtual const tchar_t*		get_draw_text() const override;
+		virtual void				set_text_width(int width) override;
 		virtual const tchar_t*		get_style_property(const tchar_t* name, bool inherited, const tchar_t* def = 0) override;
 		virtual void				parse_styles(bool is_reparse) override;
 		virtual int					get_base_line() override;
@@ -29,6 +31,7 @@ namespace litehtml
 		virtual white_space			get_white_space() const override;
 		virtual element_position	get_element_position(css_offsets* offsets = 0) const override;
 		virtual css_offsets			get_css_offsets() const override;
+		virtual void				add_memory_usage(memory_usage& usage) const override;
 
 	protected:
 		virtual void				get_content_size(size& sz, int max_width) override;
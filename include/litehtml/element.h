@@ -8,6 +8,25 @@
 namespace litehtml
 {
 	class box;
+	struct memory_item;
+	struct memory_usage;
+
+	// the content of a subtree, summed up for estimating the height of a block without a layout
+	struct content_estimate
+	{
+		int			inline_width;	// inline content not closed by a block yet
+		long long	area;			// closed lines, as width times line height
+		int			height;			// vertical outlines and fixed heights of blocks
+		int			invalid;		// parts that cannot be estimated, like positioned subtrees
+
+		content_estimate()
+		{
+			inline_width	= 0;
+			area			= 0;
+			height			= 0;
+			invalid			= 0;
+		}
+	};
 
 	class element : public std::enable_shared_from_this<element>
 	{
@@ -30,8 +49,18 @@ namespace litehtml
 		margins						m_padding;
 		margins						m_borders;
 		bool						m_skip;
+		position					m_ink_overflow;		// painted area of the subtree, in the coordinates of m_pos
+		bool						m_ink_bounded;
+		size						m_doc_extent;		// right and bottom of the subtree, in the coordinates of m_pos
+		// position among the siblings that are not text, for the :nth-* selectors; set by the parent
+		// while its m_child_index_valid is true
+		mutable int					m_child_index;
+		mutable int					m_type_index;
+		mutable int					m_type_count;
+		mutable bool				m_child_index_valid;
 		
 		virtual void select_all(const css_selector& selector, elements_vector& res);
+		memory_item& add_element_usage(memory_usage& usage, const tchar_t* type, size_t object_size) const;
 	public:
 		element(const std::shared_ptr<litehtml::document>& doc);
 		virtual ~element();
@@ -85,6 +114,9 @@ namespace litehtml
 		element::ptr				parent() const;
 		void						parent(element::ptr par);
 		bool						is_visible() const;
+		bool						is_ink_visible(int x, int y, const position* clip) const;
+		bool						is_ink_point_inside(int x, int y) const;
+		void						shift_y(int dy);
 		int							calc_width(int defVal) const;
 		int							get_inline_shift_left();
 		int							get_inline_shift_right();
@@ -129,6 +161,7 @@ namespace litehtml
 		virtual css_length			get_css_width() const;
 		virtual void				set_css_width(css_length& w);
 		virtual css_length			get_css_height() const;
+		virtual box_sizing			get_box_sizing() const;
 
 		virtual void				set_attr(const tchar_t* name, const tchar_t* val);
 		virtual const tchar_t*		get_attr(const tchar_t* name, const tchar_t* def = 0) const;
@@ -162,7 +195,12 @@ namespace litehtml
 		virtual const tchar_t*		get_style_property(const tchar_t* name, bool inherited, const tchar_t* def = 0);
 		virtual uint_ptr			get_font(font_metrics* fm = 0);
 		virtual int					get_font_size() const;
+		// the parsed color property, def_color when no element up the tree sets it
+		virtual web_color			get_text_color(const web_color& def_color) const;
 		virtual void				get_text(tstring& text);
+		virtual const tchar_t*		get_draw_text() const;
+		virtual void				set_text_width(int width);
+		virtual bool				is_measuring_text() const;
 		virtual void				parse_attributes();
 		virtual int					select(const css_selector& selector, bool apply_pseudo = true);
 		virtual int					select(const css_element_selector& selector, bool apply_pseudo = true);
@@ -195,10 +233,21 @@ namespace litehtml
 		virtual bool				get_predefined_height(int& p_height) const;
 		virtual void				calc_document_size(litehtml::size& sz, int x = 0, int y = 0);
 		virtual void				get_redraw_box(litehtml::position& pos, int x = 0, int y = 0);
+		virtual void				calc_ink_overflow();
+		virtual void				update_overflow();
+		virtual bool				set_children_clip(int x, int y);
 		virtual void				add_style(const litehtml::style& st);
 		virtual element::ptr		get_element_by_point(int x, int y, int client_x, int client_y);
 		virtual element::ptr		get_child_by_point(int x, int y, int client_x, int client_y, draw_flag flag, int zindex);
 		virtual const background*	get_background(bool own_only = false);
+		virtual int					get_defer_top() const;
+		virtual bool				is_layout_pending() const;
+		virtual int					realize_layout();
+		virtual void				update_child_height(const element::ptr& el, int dy, int old_margin);
+		virtual void				estimate_content(content_estimate& est);
+		virtual void				add_child_estimate(const content_estimate& delta);
+		virtual void				update_estimate();
+		virtual void				add_memory_usage(memory_usage& usage) const;
 	};
 
 	//////////////////////////////////////////////////////////////////////////
@@ -390,6 +439,31 @@ namespace litehtml
 		return !(m_skip || get_display() == display_none || get_visibility() != visibility_visible);
 	}
 
+	inline bool litehtml::element::is_ink_visible(int x, int y, const position* clip) const
+	{
+		if(!clip || !m_ink_bounded)
+		{
+			return true;
+		}
+		position pos = m_ink_overflow;
+		pos.x	+= x;
+		pos.y	+= y;
+		return pos.does_intersect(clip);
+	}
+
+	inline bool litehtml::element::is_ink_point_inside(int x, int y) const
+	{
+		return !m_ink_bounded || m_ink_overflow.is_point_inside(x, y);
+	}
+
+	inline void litehtml::element::shift_y(int dy)
+	{
+		// the cached extents move with the box, so the subtree is not walked again
+		m_pos.y				+= dy;
+		m_ink_overflow.y	+= dy;
+		m_doc_extent.height	+= dy;
+	}
+
 	inline position& litehtml::element::get_position()
 	{
 		return m_pos;
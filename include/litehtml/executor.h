@@ -0,0 +1,70 @@
+#ifndef LH_EXECUTOR_H
+#define LH_EXECUTOR_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+namespace litehtml
+{
+	// runs independent layout tasks, e.g. the cells of a table
+	class executor
+	{
+	public:
+		typedef std::shared_ptr<executor>	ptr;
+
+		virtual ~executor() {}
+		// calls task(0) ... task(count - 1) and returns when all of them are done;
+		// it can be called again from inside a task
+		virtual void run(int count, const std::function<void(int)>& task) = 0;
+	};
+
+	class thread_pool_executor : public executor
+	{
+		struct batch;
+		struct job
+		{
+			batch*	owner;
+			int		begin;
+			int		end;
+		};
+		struct worker
+		{
+			std::mutex		lock;
+			std::deque<job>	jobs;
+			std::thread		thread;
+		};
+
+		std::vector<std::unique_ptr<worker>>	m_workers;
+		std::mutex								m_wait_lock;
+		std::condition_variable					m_wait_cond;
+		std::atomic<int>						m_queued;
+		std::atomic<unsigned>					m_next;
+		bool									m_stop;
+	public:
+		// threads_count = 0 uses one thread per hardware core
+		thread_pool_executor(int threads_count = 0);
+		virtual ~thread_pool_executor();
+
+		virtual void run(int count, const std::function<void(int)>& task) override;
+		int threads_count() const;
+
+	private:
+		void worker_proc(int index);
+		bool take_job(int index, job& jb);
+		void execute(const job& jb);
+		void notify();
+	};
+
+	inline int thread_pool_executor::threads_count() const
+	{
+		return (int) m_workers.size();
+	}
+}
+
+#endif  // LH_EXECUTOR_H
@@ -7,6 +7,7 @@
 #include <vector>
 #include <map>
 #include <cstring>
+#include <climits>
 #include <algorithm>
 #include <sstream>
 #include "os_types.h"
@@ -35,7 +36,23 @@ namespace litehtml
 		virtual litehtml::uint_ptr	create_font(const litehtml::tchar_t* faceName, int size, int weight, litehtml::font_style italic, unsigned int decoration, litehtml::font_metrics* fm) = 0;
 		virtual void				delete_font(litehtml::uint_ptr hFont) = 0;
 		virtual int					text_width(const litehtml::tchar_t* text, litehtml::uint_ptr hFont) = 0;
+		// measures count strings drawn with the same font in one call; override to reuse per-font state
+		virtual void				text_widths(const litehtml::tchar_t* const* texts, int count, litehtml::uint_ptr hFont, int* widths)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				widths[i] = text_width(texts[i], hFont);
+			}
+		}
 		virtual void				draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) = 0;
+		// draws count strings of one line with the same font and color, each at its own position; override to set up the font and pen once
+		virtual void				draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				draw_text(hdc, texts[i], hFont, color, positions[i]);
+			}
+		}
 		virtual int					pt_to_px(int pt) = 0;
 		virtual int					get_default_font_size() const = 0;
 		virtual const litehtml::tchar_t*	get_default_font_name() const = 0;
@@ -13,6 +13,8 @@
 
 namespace litehtml
 {
+	struct list_marker;
+
 	struct line_context
 	{
 		int calculatedTop;
@@ -41,6 +43,8 @@ namespace litehtml
 		typedef std::shared_ptr<litehtml::html_tag>	ptr;
 	protected:
 		box::vector				m_boxes;
+		box::vector				m_spare_line_boxes;		// boxes of the previous layout, reused by new_box
+		box::vector				m_spare_block_boxes;
 		string_vector			m_class_values;
 		tstring					m_tag;
 		litehtml::style			m_style;
@@ -56,6 +60,7 @@ namespace litehtml
 		floated_box::vector		m_floats_left;
 		floated_box::vector		m_floats_right;
 		elements_vector			m_positioned;
+		std::vector<std::pair<int, element::ptr>>	m_z_order;	// m_positioned in the paint order, with the document order
 		background				m_bg;
 		element_position		m_el_position;
 		int						m_line_height;
@@ -65,6 +70,8 @@ namespace litehtml
 		
 		uint_ptr				m_font;
 		int						m_font_size;
+		web_color				m_color;
+		bool					m_has_color;
 		font_metrics			m_font_metrics;
 
 		css_margins				m_css_margins;
@@ -82,11 +89,18 @@ namespace litehtml
 		overflow				m_overflow;
 		visibility				m_visibility;
 		int						m_z_index;
+		mutable int				m_child_count;		// children that are not text, see update_child_index
 		box_sizing				m_box_sizing;
 
 		int_int_cache			m_cahe_line_left;
 		int_int_cache			m_cahe_line_right;
 
+		// children by rows of their ink overflow, to hit-test elements with many children
+		std::vector<std::vector<int>>	m_hit_rows;
+		std::vector<int>		m_hit_always;
+		int						m_hit_top;
+		int						m_hit_row_height;
+
 		// data for table rendering
 		std::unique_ptr<table_grid>	m_grid;
 		css_length				m_css_border_spacing_x;
@@ -94,6 +108,28 @@ namespace litehtml
 		int						m_border_spacing_x;
 		int						m_border_spacing_y;
 		border_collapse			m_border_collapse;
+		table_layout			m_table_layout;
+		bool					m_cells_static;
+
+		// data for lazy layout
+		int						m_defer_top;
+		bool					m_layout_pending;
+		int						m_pending_x;
+		int						m_pending_width;
+		int						m_layout_width;
+		int						m_layout_height;
+		margins					m_layout_margins;
+		// content of the children for estimating deferred blocks, without walking the subtree
+		content_estimate		m_estimate;
+
+		// line breaks of the last layout and the content widths they are valid for
+		bool					m_inline_only;
+		bool					m_breaks_valid;
+		int						m_breaks_min_width;
+		int						m_breaks_max_width;
+		int						m_breaks_ret_width;
+		// the text children parsed now are measured by measure_text_children
+		bool					m_measuring_text;
 
 		virtual void			select_all(const css_selector& selector, elements_vector& res) override;
 
@@ -114,6 +150,8 @@ namespace litehtml
 
 		int							get_cleared_top(const element::ptr &el, int line_top) const;
 		int							finish_last_box(bool end_of_render = false);
+		void						recycle_boxes();
+		void						recycle_last_box();
 
 		virtual bool				appendChild(const element::ptr &el) override;
 		virtual bool				removeChild(const element::ptr &el) override;
@@ -131,6 +169,7 @@ namespace litehtml
 		virtual css_offsets			get_css_offsets() const override;
 		virtual void				set_css_width(css_length& w) override;
 		virtual css_length			get_css_height() const override;
+		virtual box_sizing			get_box_sizing() const override;
 		virtual element_clear		get_clear() const override;
 		virtual size_t				get_children_count() const override;
 		virtual element::ptr		get_child(int idx) const override;
@@ -162,12 +201,14 @@ namespace litehtml
 		virtual style_display		get_display() const override;
 		virtual visibility			get_visibility() const override;
 		virtual void				parse_styles(bool is_reparse = false) override;
+		virtual bool				is_measuring_text() const override;
 		virtual void				draw(uint_ptr hdc, int x, int y, const position* clip) override;
 		virtual void				draw_background(uint_ptr hdc, int x, int y, const position* clip) override;
 
 		virtual const tchar_t*		get_style_property(const tchar_t* name, bool inherited, const tchar_t* def = 0) override;
 		virtual uint_ptr			get_font(font_metrics* fm = 0) override;
 		virtual int					get_font_size() const override;
+		virtual web_color			get_text_color(const web_color& def_color) const override;
 
 		elements_vector&			children();
 		virtual void				calc_outlines(int parent_width) override;
@@ -211,6 +252,9 @@ namespace litehtml
 		virtual void				draw_stacking_context(uint_ptr hdc, int x, int y, const position* clip, bool with_positioned) override;
 		virtual void				calc_document_size(litehtml::size& sz, int x = 0, int y = 0) override;
 		virtual void				get_redraw_box(litehtml::position& pos, int x = 0, int y = 0) override;
+		virtual void				calc_ink_overflow() override;
+		virtual void				update_overflow() override;
+		virtual bool				set_children_clip(int x, int y) override;
 		virtual void				add_style(const litehtml::style& st) override;
 		virtual element::ptr		get_element_by_point(int x, int y, int client_x, int client_y) override;
 		virtual element::ptr		get_child_by_point(int x, int y, int client_x, int client_y, draw_flag flag, int zindex) override;
@@ -219,17 +263,45 @@ namespace litehtml
 		virtual bool				is_nth_last_child(const element::ptr& el, int num, int off, bool of_type) const override;
 		virtual bool				is_only_child(const element::ptr& el, bool of_type) const override;
 		virtual const background*	get_background(bool own_only = false) override;
+		virtual int					get_defer_top() const override;
+		virtual bool				is_layout_pending() const override;
+		virtual int					realize_layout() override;
+		virtual void				update_child_height(const element::ptr& el, int dy, int old_margin) override;
+		virtual void				estimate_content(content_estimate& est) override;
+		virtual void				add_child_estimate(const content_estimate& delta) override;
+		virtual void				update_estimate() override;
+		virtual void				add_memory_usage(memory_usage& usage) const override;
 
 	protected:
+		void						add_tag_usage(memory_usage& usage, size_t object_size) const;
 		void						draw_children_box(uint_ptr hdc, int x, int y, const position* clip, draw_flag flag, int zindex);
 		void						draw_children_table(uint_ptr hdc, int x, int y, const position* clip, draw_flag flag, int zindex);
+		int							match_selector(const css_selector& selector, bool apply_pseudo);
+		element::ptr				get_child_item_by_point(const element::ptr& el, int x, int y, int client_x, int client_y, draw_flag flag, int zindex);
+		element::ptr				get_cell_by_point(int x, int y, int client_x, int client_y, draw_flag flag, int zindex);
+		void						update_ink_overflow();
+		void						update_document_size();
+		void						build_hit_index();
+		void						sort_z_order();
+		void						draw_positioned_child(uint_ptr hdc, int x, int y, const position* clip, const element::ptr& el);
 		int							render_box(int x, int y, int max_width, bool second_pass = false);
 		int							render_table(int x, int y, int max_width, bool second_pass = false);
+		bool						defer_render(int x, int y, int max_width);
+		void						init_defer_top();
+		bool						reuse_line_breaks(int max_width);
+		void						save_line_breaks(int max_width, int lines_width);
+		bool						estimate_height(int width, int& height);
+		void						calc_estimate();
+		void						propagate_estimate(const content_estimate& old_est);
+		void						estimate_block(content_estimate& est) const;
 		int							fix_line_width(int max_width, element_float flt);
 		void						parse_background();
+		void						measure_text_children();
 		void						init_background_paint( position pos, background_paint &bg_paint, const background* bg );
 		void						draw_list_marker( uint_ptr hdc, const position &pos );
+		void						get_list_marker( const position &pos, list_marker &lm );
 		void						parse_nth_child_params( tstring param, int &num, int &off );
+		void						update_child_index() const;
 		void						remove_before_after();
 		litehtml::element::ptr		get_element_before();
 		litehtml::element::ptr		get_element_after();
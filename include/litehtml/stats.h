@@ -0,0 +1,197 @@
+#ifndef LH_STATS_H
+#define LH_STATS_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+namespace litehtml
+{
+	class element;
+	class css_selector;
+
+	// wall time of the steps of the document creation, in nanoseconds
+	struct document_timings
+	{
+		long long	parse_html;			// gumbo and the element tree
+		long long	apply_stylesheet;	// master, document and user styles
+		long long	parse_attributes;
+		long long	parse_css;			// the style sheets of the document
+		long long	parse_styles;
+		long long	fix_tables;
+		long long	init;
+
+		document_timings()
+		{
+			parse_html			= 0;
+			apply_stylesheet	= 0;
+			parse_attributes	= 0;
+			parse_css			= 0;
+			parse_styles		= 0;
+			fix_tables			= 0;
+			init				= 0;
+		}
+	};
+
+	// the creation timings are always taken, the rest is collected only when enabled
+	// by context::set_collect_stats or document::set_collect_stats
+	struct document_stats
+	{
+		document_timings	creation;
+		long long			render_time;		// nanoseconds over all document::render calls
+		int					render_count;
+		long long			draw_time;			// nanoseconds over all document::draw calls
+		int					draw_count;
+
+		std::map<tstring, int>	elements;		// by tag name, text nodes are #text
+		long long			selectors_tested;	// html_tag::select calls, the ancestors and siblings of a selector included
+		long long			selectors_matched;
+		long long			text_width_calls;	// strings measured by the container
+		int					fonts_created;
+		long long			element_renders;	// html_tag::render calls
+		long long			line_boxes;
+		long long			block_boxes;
+		std::unordered_map<const element*, int>	renders_by_element;	// in the last document::render
+
+		document_stats();
+
+		void	add_counters(const document_stats& val);
+		int		max_element_renders() const;
+	};
+
+	struct selector_counters
+	{
+		long long	attempts;	// html_tag::select calls with the selector from outside of a selector match
+		long long	matches;
+		long long	time;		// nanoseconds, the ancestors and siblings tested included
+		long long	hops;		// ancestors and siblings tested for the combinators
+
+		selector_counters() : attempts(0), matches(0), time(0), hops(0) {}
+	};
+
+	// the matching cost of every selector, collected only when enabled
+	// by context::set_profile_selectors or document::set_profile_selectors
+	class selector_profile
+	{
+	public:
+		struct entry
+		{
+			tstring				source;		// selector text
+			tstring				origin;		// base url of the style sheet, "master" for the master style sheet
+			selector_counters	counters;
+		};
+	private:
+		std::unordered_map<const css_selector*, entry>	m_entries;
+		entry*			m_current;
+	public:
+		selector_profile() : m_current(0) {}
+
+		void			clear();
+		size_t			size() const;
+		const entry*	find(const css_selector* selector) const;
+		// the selectors that took most of the time, most expensive first
+		void			top(size_t count, std::vector<const entry*>& entries) const;
+		std::string		report(size_t count) const;
+
+		// returns null for the selectors tested while matching another one, they count as its hops
+		entry*			begin_select(const css_selector& selector);
+		void			end_select(entry* en, bool matched, long long time);
+	};
+
+	struct memory_item
+	{
+		size_t	count;
+		size_t	bytes;
+
+		memory_item() : count(0), bytes(0) {}
+
+		void add(size_t objects, size_t size)
+		{
+			count	+= objects;
+			bytes	+= size;
+		}
+	};
+
+	// estimated memory held by a document, see document::memory_usage.
+	// containers count with their capacity, strings and members embedded in an object count with the object
+	struct memory_usage
+	{
+		std::map<tstring, memory_item>	elements;	// element objects by tag name, #text, #space, #comment...
+		memory_item		styles;				// style properties and backgrounds of the elements
+		memory_item		attributes;
+		memory_item		texts;				// text of the text nodes, scripts and comments
+		memory_item		transformed_texts;	// the copies made for text-transform
+		memory_item		used_selectors;
+		memory_item		boxes;				// line and block boxes
+		memory_item		table_grids;
+		memory_item		fonts;				// the font map of the document, the fonts themselves belong to the container
+		memory_item		stylesheets;		// selectors, styles and texts of the document style sheets
+
+		size_t			total_bytes() const;
+
+		// heap blocks of the standard containers, with the usual allocator overhead
+		static size_t	string_bytes(const tstring& str);
+		static size_t	string_vector_bytes(const string_vector& strings);
+		static size_t	string_map_bytes(const string_map& strings);
+		static size_t	map_node_bytes(size_t value_size);
+		static size_t	shared_object_bytes(size_t object_size);
+	};
+
+#ifndef LITEHTML_NO_STATS
+	// the stats of the document being processed on this thread, or null
+	extern thread_local document_stats* current_stats;
+
+	#define LITEHTML_STATS_ADD(counter, n)	do { if(litehtml::current_stats) litehtml::current_stats->counter += (n); } while(0)
+
+	class stats_scope
+	{
+		document_stats*	m_prev;
+	public:
+		stats_scope(document_stats* stats)
+		{
+			m_prev = current_stats;
+			current_stats = stats;
+		}
+		~stats_scope()
+		{
+			current_stats = m_prev;
+		}
+	};
+
+	// the selector profile of the document being styled on this thread, or null
+	extern thread_local selector_profile* current_selector_profile;
+
+	class selector_profile_scope
+	{
+		selector_profile*	m_prev;
+	public:
+		selector_profile_scope(selector_profile* profile)
+		{
+			m_prev = current_selector_profile;
+			current_selector_profile = profile;
+		}
+		~selector_profile_scope()
+		{
+			current_selector_profile = m_prev;
+		}
+	};
+#else
+	#define LITEHTML_STATS_ADD(counter, n)	do {} while(0)
+
+	class stats_scope
+	{
+	public:
+		stats_scope(document_stats* stats) {}
+	};
+
+	class selector_profile_scope
+	{
+	public:
+		selector_profile_scope(selector_profile* profile) {}
+	};
+#endif
+}
+
+#endif  // LH_STATS_H
@@ -62,18 +62,7 @@ namespace litehtml
 
 		void add_property(const tchar_t* name, const tchar_t* val, const tchar_t* baseurl, bool important);
 
-		const tchar_t* get_property(const tchar_t* name) const
-		{
-			if(name)
-			{
-				props_map::const_iterator f = m_properties.find(name);
-				if(f != m_properties.end())
-				{
-					return f->second.m_value.c_str();
-				}
-			}
-			return 0;
-		}
+		const tchar_t* get_property(const tchar_t* name) const;
 
 		void combine(const litehtml::style& src);
 		void clear()
@@ -81,6 +70,9 @@ namespace litehtml
 			m_properties.clear();
 		}
 
+		// heap bytes of the properties
+		size_t memory_size() const;
+
 	private:
 		void parse_property(const tstring& txt, const tchar_t* baseurl);
 		void parse(const tchar_t* txt, const tchar_t* baseurl);
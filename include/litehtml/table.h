@@ -76,6 +76,7 @@ namespace litehtml
 		int			max_width;
 		int			width;
 		css_length	css_width;
+		css_length	css_fixed_width;
 		int			border_left;
 		int			border_right;
 		int			left;
@@ -91,6 +92,7 @@ namespace litehtml
 			max_width		= 0;
 			width			= 0;
 			css_width.predef(0);
+			css_fixed_width.predef(0);
 		}
 
 		table_column(int min_w, int max_w)
@@ -103,6 +105,7 @@ namespace litehtml
 			min_width		= min_w;
 			width			= 0;
 			css_width.predef(0);
+			css_fixed_width.predef(0);
 		}
 
 		table_column(const table_column& val)
@@ -115,6 +118,7 @@ namespace litehtml
 			min_width		= val.min_width;
 			width			= val.width;
 			css_width		= val.css_width;
+			css_fixed_width	= val.css_fixed_width;
 		}
 	};
 
@@ -199,12 +203,12 @@ namespace litehtml
 
 	class table_grid
 	{
-	public:
-		typedef std::vector< std::vector<table_cell> >	rows;
-	private:
 		int						m_rows_count;
 		int						m_cols_count;
-		rows					m_cells;
+		std::vector<table_cell>	m_cells;		// row-major, m_cols_count cells per row after finish()
+		std::vector<int>		m_row_start;	// first cell of each row while the grid is built
+		std::vector<int>		m_span_end;		// last row covered by a rowspan in each column
+		int						m_max_rowspan;
 		table_column::vector	m_columns;
 		table_row::vector		m_rows;
 	public:
@@ -213,6 +217,7 @@ namespace litehtml
 		{
 			m_rows_count	= 0;
 			m_cols_count	= 0;
+			m_max_rowspan	= 1;
 		}
 
 		void			clear();
@@ -232,9 +237,12 @@ namespace litehtml
 		void			distribute_width(int width, int start, int end);
 		void			distribute_width(int width, int start, int end, table_column_accessor* acc);
 		int				calc_table_width(int block_width, bool is_auto, int& min_table_width, int& max_table_width);
+		int				calc_fixed_table_width(int block_width);
 		void			calc_horizontal_positions(margins& table_borders, border_collapse bc, int bdr_space_x);
 		void			calc_vertical_positions(margins& table_borders, border_collapse bc, int bdr_space_y);
 		void			calc_rows_height(int blockHeight, int borderSpacingY);
+		bool			find_rows(int top, int bottom, int& first_row, int& last_row);
+		size_t			memory_size() const;
 	};
 }
 
@@ -0,0 +1,137 @@
+#ifndef LH_TRACE_H
+#define LH_TRACE_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "types.h"
+#include "container_proxy.h"
+
+namespace litehtml
+{
+	class element;
+
+	// receives the trace as it is written, it is used under the lock of the tracer
+	class trace_writer
+	{
+	public:
+		virtual ~trace_writer() {}
+		virtual void write(const char* data, size_t size) = 0;
+	};
+
+	// writes the spans of a document in the Chrome trace-event format (a JSON array of complete events),
+	// it can be loaded into about:tracing or Perfetto
+	class tracer
+	{
+		trace_writer*							m_writer;
+		long long								m_min_duration;		// nanoseconds
+		std::chrono::steady_clock::time_point	m_start;
+		std::mutex								m_lock;
+		std::map<std::thread::id, int>			m_threads;
+		bool									m_first;
+		bool									m_finished;
+	public:
+		typedef std::shared_ptr<tracer>	ptr;
+
+		// element and container spans shorter than min_duration_us are dropped
+		tracer(trace_writer* writer, int min_duration_us = 0);
+		~tracer();
+
+		// nanoseconds since the tracer was created
+		long long	now() const;
+		long long	to_trace_time(std::chrono::steady_clock::time_point tp) const;
+		long long	min_duration() const;
+		void		add_span(const char* category, const char* name, long long start, long long duration, const element* el, const char* arg_name, const tchar_t* arg_value);
+		// closes the JSON array, nothing is written after it
+		void		finish();
+	};
+
+	// the tracer of the document being processed on this thread, or null
+	extern thread_local tracer* current_tracer;
+
+	class trace_scope
+	{
+		tracer*	m_prev;
+	public:
+		trace_scope(tracer* tr)
+		{
+			m_prev = current_tracer;
+			current_tracer = tr;
+		}
+		~trace_scope()
+		{
+			current_tracer = m_prev;
+		}
+	};
+
+	// adds a span from its construction to its destruction to the current tracer
+	class trace_span
+	{
+		tracer*			m_tracer;
+		const char*		m_category;
+		const char*		m_name;
+		const element*	m_element;
+		const char*		m_arg_name;
+		const tchar_t*	m_arg_value;
+		bool			m_filtered;
+		long long		m_start;
+	public:
+		trace_span(const char* category, const char* name) : m_tracer(current_tracer), m_category(category), m_name(name), m_element(0), m_arg_name(0), m_arg_value(0), m_filtered(false)
+		{
+			m_start = m_tracer ? m_tracer->now() : 0;
+		}
+		// spans of elements are dropped if they are shorter than the minimum duration of the tracer
+		trace_span(const char* category, const char* name, const element* el) : m_tracer(current_tracer), m_category(category), m_name(name), m_element(el), m_arg_name(0), m_arg_value(0), m_filtered(true)
+		{
+			m_start = m_tracer ? m_tracer->now() : 0;
+		}
+		// the argument must stay valid for the lifetime of the span
+		trace_span(const char* category, const char* name, const char* arg_name, const tchar_t* arg_value, bool filtered = false) : m_tracer(current_tracer), m_category(category), m_name(name), m_element(0), m_arg_name(arg_name), m_arg_value(arg_value), m_filtered(filtered)
+		{
+			m_start = m_tracer ? m_tracer->now() : 0;
+		}
+		~trace_span()
+		{
+			if(m_tracer)
+			{
+				long long duration = m_tracer->now() - m_start;
+				if(!m_filtered || duration >= m_tracer->min_duration())
+				{
+					m_tracer->add_span(m_category, m_name, m_start, duration, m_element, m_arg_name, m_arg_value);
+				}
+			}
+		}
+	};
+
+	// wraps the calls into the container with spans, the document puts it in front of its container while tracing
+	class tracing_container : public container_proxy
+	{
+	public:
+		tracing_container(document_container* target);
+
+		virtual uint_ptr					create_font(const tchar_t* faceName, int size, int weight, font_style italic, unsigned int decoration, font_metrics* fm) override;
+		virtual int							text_width(const tchar_t* text, uint_ptr hFont) override;
+		virtual void						text_widths(const tchar_t* const* texts, int count, uint_ptr hFont, int* widths) override;
+		virtual void						draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos) override;
+		virtual void						draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color) override;
+		virtual void						draw_list_marker(uint_ptr hdc, const list_marker& marker) override;
+		virtual void						load_image(const tchar_t* src, const tchar_t* baseurl, bool redraw_on_ready) override;
+		virtual void						get_image_size(const tchar_t* src, const tchar_t* baseurl, size& sz) override;
+		virtual void						draw_background(uint_ptr hdc, const background_paint& bg) override;
+		virtual void						draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root) override;
+		virtual void						import_css(tstring& text, const tstring& url, tstring& baseurl) override;
+		virtual void						set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y) override;
+		virtual void						del_clip() override;
+		virtual std::shared_ptr<element>	create_element(const tchar_t* tag_name, const string_map& attributes, const std::shared_ptr<document>& doc) override;
+	};
+
+	inline long long tracer::min_duration() const
+	{
+		return m_min_duration;
+	}
+}
+
+#endif  // LH_TRACE_H
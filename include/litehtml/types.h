@@ -485,6 +485,14 @@ namespace litehtml
 		border_collapse_separate,
 	};
 
+#define table_layout_strings		_t("auto;fixed")
+
+	enum table_layout
+	{
+		table_layout_auto,
+		table_layout_fixed,
+	};
+
 
 #define pseudo_class_strings		_t("only-child;only-of-type;first-child;first-of-type;last-child;last-of-type;nth-child;nth-of-type;nth-last-child;nth-last-of-type;not;lang")
 
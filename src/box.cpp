@@ -85,7 +85,7 @@ void litehtml::block_box::y_shift( int shift )
 	m_box_top += shift;
 	if(m_element)
 	{
-		m_element->m_pos.y += shift;
+		m_element->shift_y(shift);
 	}
 }
 
@@ -94,6 +94,27 @@ void litehtml::block_box::new_width( int left, int right, elements_vector& els )
 
 }
 
+void litehtml::block_box::get_right_range( int& min_right, int& max_right )
+{
+	// block boxes are rendered again on every width change
+	min_right = max_right = m_box_right;
+}
+
+void litehtml::block_box::set_right( int right )
+{
+	m_box_right = right;
+}
+
+size_t litehtml::block_box::memory_size()
+{
+	return sizeof(block_box);
+}
+
+void litehtml::block_box::clear_elements()
+{
+	m_element = 0;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 litehtml::box_type litehtml::line_box::get_type()
@@ -171,24 +192,8 @@ void litehtml::line_box::finish(bool last_box)
 	int base_line	= m_font_metrics.base_line();
 	int line_height = m_line_height;
 
-	int add_x = 0;
-	switch(m_text_align)
-	{
-	case text_align_right:
-		if(m_width < (m_box_right - m_box_left))
-		{
-			add_x = (m_box_right - m_box_left) - m_width;
-		}
-		break;
-	case text_align_center:
-		if(m_width < (m_box_right - m_box_left))
-		{
-			add_x = ((m_box_right - m_box_left) - m_width) / 2;
-		}
-		break;
-	default:
-		add_x = 0;
-	}
+	int add_x = calc_align_shift();
+	m_align_shift = add_x;
 
 	m_height = 0;
 	// find line box baseline and line-height
@@ -295,6 +300,29 @@ void litehtml::line_box::finish(bool last_box)
 	m_baseline = (base_line - y1) - (m_height - line_height);
 }
 
+int litehtml::line_box::calc_align_shift()
+{
+	int add_x = 0;
+	switch(m_text_align)
+	{
+	case text_align_right:
+		if(m_width < (m_box_right - m_box_left))
+		{
+			add_x = (m_box_right - m_box_left) - m_width;
+		}
+		break;
+	case text_align_center:
+		if(m_width < (m_box_right - m_box_left))
+		{
+			add_x = ((m_box_right - m_box_left) - m_width) / 2;
+		}
+		break;
+	default:
+		add_x = 0;
+	}
+	return add_x;
+}
+
 bool litehtml::line_box::can_hold(const element::ptr &el, white_space ws)
 {
 	if(!el->is_inline_box()) return false;
@@ -309,10 +337,14 @@ bool litehtml::line_box::can_hold(const element::ptr &el, white_space ws)
 		return true;
 	}
 
-	if(m_box_left + m_width + el->width() + el->get_inline_shift_left() + el->get_inline_shift_right() > m_box_right)
+	// remember the widths this decision depends on
+	int el_right = m_box_left + m_width + el->width() + el->get_inline_shift_left() + el->get_inline_shift_right();
+	if(el_right > m_box_right)
 	{
+		m_max_right = std::min(m_max_right, el_right - 1);
 		return false;
 	}
+	m_min_right = std::max(m_min_right, el_right);
 
 	return true;
 }
@@ -371,7 +403,7 @@ void litehtml::line_box::y_shift( int shift )
 	m_box_top += shift;
 	for (auto& el : m_items)
 	{
-		el->m_pos.y += shift;
+		el->shift_y(shift);
 	}
 }
 
@@ -432,3 +464,34 @@ void litehtml::line_box::new_width( int left, int right, elements_vector& els )
 	}
 }
 
+
+void litehtml::line_box::get_right_range( int& min_right, int& max_right )
+{
+	min_right = m_min_right;
+	max_right = m_max_right;
+}
+
+void litehtml::line_box::set_right( int right )
+{
+	// the line keeps its elements, only the alignment is updated
+	m_box_right = right;
+	int add_x = calc_align_shift();
+	if(add_x != m_align_shift)
+	{
+		for(const auto& el : m_items)
+		{
+			el->m_pos.x += add_x - m_align_shift;
+		}
+		m_align_shift = add_x;
+	}
+}
+
+size_t litehtml::line_box::memory_size()
+{
+	return sizeof(line_box) + m_items.capacity() * sizeof(element::ptr);
+}
+
+void litehtml::line_box::clear_elements()
+{
+	m_items.clear();
+}
@@ -0,0 +1,146 @@
+#include "html.h"
+#include "container_proxy.h"
+
+litehtml::container_proxy::container_proxy(document_container* target) : m_target(target)
+{
+}
+
+litehtml::uint_ptr litehtml::container_proxy::create_font(const tchar_t* faceName, int size, int weight, font_style italic, unsigned int decoration, font_metrics* fm)
+{
+	return m_target->create_font(faceName, size, weight, italic, decoration, fm);
+}
+
+void litehtml::container_proxy::delete_font(uint_ptr hFont)
+{
+	m_target->delete_font(hFont);
+}
+
+int litehtml::container_proxy::text_width(const tchar_t* text, uint_ptr hFont)
+{
+	return m_target->text_width(text, hFont);
+}
+
+void litehtml::container_proxy::text_widths(const tchar_t* const* texts, int count, uint_ptr hFont, int* widths)
+{
+	m_target->text_widths(texts, count, hFont, widths);
+}
+
+void litehtml::container_proxy::draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos)
+{
+	m_target->draw_text(hdc, text, hFont, color, pos);
+}
+
+void litehtml::container_proxy::draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color)
+{
+	m_target->draw_text_run(hdc, texts, positions, count, hFont, color);
+}
+
+int litehtml::container_proxy::pt_to_px(int pt)
+{
+	return m_target->pt_to_px(pt);
+}
+
+int litehtml::container_proxy::get_default_font_size() const
+{
+	return m_target->get_default_font_size();
+}
+
+const litehtml::tchar_t* litehtml::container_proxy::get_default_font_name() const
+{
+	return m_target->get_default_font_name();
+}
+
+void litehtml::container_proxy::draw_list_marker(uint_ptr hdc, const list_marker& marker)
+{
+	m_target->draw_list_marker(hdc, marker);
+}
+
+void litehtml::container_proxy::load_image(const tchar_t* src, const tchar_t* baseurl, bool redraw_on_ready)
+{
+	m_target->load_image(src, baseurl, redraw_on_ready);
+}
+
+void litehtml::container_proxy::get_image_size(const tchar_t* src, const tchar_t* baseurl, size& sz)
+{
+	m_target->get_image_size(src, baseurl, sz);
+}
+
+void litehtml::container_proxy::draw_background(uint_ptr hdc, const background_paint& bg)
+{
+	m_target->draw_background(hdc, bg);
+}
+
+void litehtml::container_proxy::draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root)
+{
+	m_target->draw_borders(hdc, borders, draw_pos, root);
+}
+
+void litehtml::container_proxy::set_caption(const tchar_t* caption)
+{
+	m_target->set_caption(caption);
+}
+
+void litehtml::container_proxy::set_base_url(const tchar_t* base_url)
+{
+	m_target->set_base_url(base_url);
+}
+
+void litehtml::container_proxy::link(const std::shared_ptr<document>& doc, const element::ptr& el)
+{
+	m_target->link(doc, el);
+}
+
+void litehtml::container_proxy::on_anchor_click(const tchar_t* url, const element::ptr& el)
+{
+	m_target->on_anchor_click(url, el);
+}
+
+void litehtml::container_proxy::set_cursor(const tchar_t* cursor)
+{
+	m_target->set_cursor(cursor);
+}
+
+void litehtml::container_proxy::transform_text(tstring& text, text_transform tt)
+{
+	m_target->transform_text(text, tt);
+}
+
+void litehtml::container_proxy::import_css(tstring& text, const tstring& url, tstring& baseurl)
+{
+	m_target->import_css(text, url, baseurl);
+}
+
+void litehtml::container_proxy::set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y)
+{
+	m_target->set_clip(pos, bdr_radius, valid_x, valid_y);
+}
+
+void litehtml::container_proxy::del_clip()
+{
+	m_target->del_clip();
+}
+
+void litehtml::container_proxy::get_client_rect(position& client) const
+{
+	m_target->get_client_rect(client);
+}
+
+std::shared_ptr<litehtml::element> litehtml::container_proxy::create_element(const tchar_t* tag_name, const string_map& attributes, const std::shared_ptr<document>& doc)
+{
+	return m_target->create_element(tag_name, attributes, doc);
+}
+
+void litehtml::container_proxy::get_media_features(media_features& media) const
+{
+	m_target->get_media_features(media);
+}
+
+void litehtml::container_proxy::get_language(tstring& language, tstring& culture) const
+{
+	m_target->get_language(language, culture);
+}
+
+litehtml::tstring litehtml::container_proxy::resolve_color(const tstring& color) const
+{
+	return m_target->resolve_color(color);
+}
@@ -9,4 +9,10 @@ void litehtml::context::load_master_stylesheet( const tchar_t* str )
 
 	m_master_css.parse_stylesheet(str, 0, std::shared_ptr<litehtml::document>(), media_query_list::ptr());
 	m_master_css.sort_selectors();
+#ifndef LITEHTML_NO_STATS
+	for(const auto& sel : m_master_css.selectors())
+	{
+		sel->m_origin = _t("master");
+	}
+#endif
 }
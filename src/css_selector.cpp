@@ -257,6 +257,24 @@ void litehtml::css_selector::calc_specificity()
 	}
 }
 
+size_t litehtml::css_selector::memory_size() const
+{
+	size_t ret = memory_usage::shared_object_bytes(sizeof(css_selector));
+#ifndef LITEHTML_NO_STATS
+	ret += memory_usage::string_bytes(m_source) + memory_usage::string_bytes(m_origin);
+#endif
+	ret += memory_usage::string_bytes(m_right.m_tag) + m_right.m_attrs.capacity() * sizeof(css_attribute_selector);
+	for(css_attribute_selector::vector::const_iterator i = m_right.m_attrs.begin(); i != m_right.m_attrs.end(); i++)
+	{
+		ret += memory_usage::string_bytes(i->attribute) + memory_usage::string_bytes(i->val) + memory_usage::string_vector_bytes(i->class_val);
+	}
+	if(m_left)
+	{
+		ret += m_left->memory_size();
+	}
+	return ret;
+}
+
 void litehtml::css_selector::add_media_to_doc( document* doc ) const
 {
 	if(m_media_query && doc)
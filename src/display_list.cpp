@@ -0,0 +1,275 @@
+#include "html.h"
+#include "display_list.h"
+#include "container_proxy.h"
+
+namespace
+{
+	// records the paint calls into a display list and forwards everything else to the real container
+	class recording_container : public litehtml::container_proxy
+	{
+		litehtml::display_list*			m_list;
+	public:
+		recording_container(litehtml::document_container* target, litehtml::display_list* list) : litehtml::container_proxy(target), m_list(list)
+		{
+		}
+
+		virtual void draw_text(litehtml::uint_ptr hdc, const litehtml::tchar_t* text, litehtml::uint_ptr hFont, litehtml::web_color color, const litehtml::position& pos) override
+		{
+			m_list->add_text(text, hFont, color, pos);
+		}
+		virtual void draw_text_run(litehtml::uint_ptr hdc, const litehtml::tchar_t* const* texts, const litehtml::position* positions, int count, litehtml::uint_ptr hFont, litehtml::web_color color) override
+		{
+			for(int i = 0; i < count; i++)
+			{
+				m_list->add_text(texts[i], hFont, color, positions[i]);
+			}
+		}
+		virtual void draw_list_marker(litehtml::uint_ptr hdc, const litehtml::list_marker& marker) override
+		{
+			m_list->add_list_marker(marker.image, marker.baseurl, marker.marker_type, marker.color, marker.pos);
+		}
+		virtual void draw_background(litehtml::uint_ptr hdc, const litehtml::background_paint& bg) override
+		{
+			m_list->add_background(bg);
+		}
+		virtual void draw_borders(litehtml::uint_ptr hdc, const litehtml::borders& borders, const litehtml::position& draw_pos, bool root) override
+		{
+			m_list->add_borders(borders, draw_pos, root);
+		}
+		virtual void set_clip(const litehtml::position& pos, const litehtml::border_radiuses& bdr_radius, bool valid_x, bool valid_y) override
+		{
+			m_list->add_set_clip(pos, bdr_radius, valid_x, valid_y);
+		}
+		virtual void del_clip() override
+		{
+			m_list->add_del_clip();
+		}
+	};
+
+	enum
+	{
+		item_flag_root		= 0x01,
+		item_flag_valid_x	= 0x02,
+		item_flag_valid_y	= 0x04,
+	};
+
+	bool same_color(const litehtml::web_color& left, const litehtml::web_color& right)
+	{
+		return left.red == right.red && left.green == right.green && left.blue == right.blue && left.alpha == right.alpha;
+	}
+
+	litehtml::position translate(const litehtml::position& pos, int x, int y)
+	{
+		litehtml::position ret = pos;
+		ret.x += x;
+		ret.y += y;
+		return ret;
+	}
+}
+
+litehtml::display_list::display_list()
+{
+	m_valid = false;
+}
+
+void litehtml::display_list::record(document_container* target, const std::function<void(document_container*)>& draw)
+{
+	clear();
+	recording_container recorder(target, this);
+	draw(&recorder);
+	// a clip left open by the drawing code is closed at the end of the list
+	while(!m_open_clips.empty())
+	{
+		add_del_clip();
+	}
+	m_valid = true;
+}
+
+void litehtml::display_list::replay(document_container* container, uint_ptr hdc, int x, int y, const position* clip) const
+{
+	// scratch buffers kept between replays, so a steady state replay does not allocate
+	static thread_local std::vector<const tchar_t*> run_texts;
+	static thread_local std::vector<position> run_positions;
+	for(size_t i = 0; i < m_items.size(); i++)
+	{
+		const display_item& item = m_items[i];
+		switch(item.type)
+		{
+		case display_item_text:
+			if(translate(item.pos, x, y).does_intersect(clip))
+			{
+				run_texts.clear();
+				run_positions.clear();
+				for(int text = item.index; text < item.index + item.end; text++)
+				{
+					position pos = translate(m_text_positions[text], x, y);
+					if(pos.does_intersect(clip))
+					{
+						run_texts.push_back(m_texts[text].c_str());
+						run_positions.push_back(pos);
+					}
+				}
+				if(run_texts.size() == 1)
+				{
+					container->draw_text(hdc, run_texts[0], item.font, item.color, run_positions[0]);
+				} else if(!run_texts.empty())
+				{
+					container->draw_text_run(hdc, &run_texts[0], &run_positions[0], (int) run_texts.size(), item.font, item.color);
+				}
+			}
+			break;
+		case display_item_background:
+			{
+				const background_paint& item_bg = m_backgrounds[item.index];
+				if(item_bg.is_root || translate(item_bg.clip_box, x, y).does_intersect(clip))
+				{
+					background_paint bg = item_bg;
+					bg.clip_box		= translate(bg.clip_box, x, y);
+					bg.origin_box	= translate(bg.origin_box, x, y);
+					bg.border_box	= translate(bg.border_box, x, y);
+					if(bg.image_size.width && bg.image_size.height)
+					{
+						// the image position is only set together with the image size
+						bg.position_x	+= x;
+						bg.position_y	+= y;
+					}
+					container->draw_background(hdc, bg);
+				}
+			}
+			break;
+		case display_item_borders:
+			{
+				position pos = translate(item.pos, x, y);
+				if((item.flags & item_flag_root) || pos.does_intersect(clip))
+				{
+					container->draw_borders(hdc, m_borders[item.index], pos, (item.flags & item_flag_root) != 0);
+				}
+			}
+			break;
+		case display_item_list_marker:
+			{
+				list_marker marker;
+				marker.pos			= translate(item.pos, x, y);
+				if(marker.pos.does_intersect(clip))
+				{
+					marker.image		= m_texts[item.index];
+					marker.baseurl		= m_texts[item.index + 1].c_str();
+					marker.marker_type	= (list_style_type) item.flags;
+					marker.color		= item.color;
+					container->draw_list_marker(hdc, marker);
+				}
+			}
+			break;
+		case display_item_set_clip:
+			{
+				position pos = translate(item.pos, x, y);
+				bool valid_x = (item.flags & item_flag_valid_x) != 0;
+				bool valid_y = (item.flags & item_flag_valid_y) != 0;
+				if(!valid_x || !valid_y || pos.does_intersect(clip))
+				{
+					container->set_clip(pos, m_radiuses[item.index], valid_x, valid_y);
+				} else
+				{
+					// nothing inside the clip can be visible
+					i = item.end;
+				}
+			}
+			break;
+		case display_item_del_clip:
+			container->del_clip();
+			break;
+		}
+	}
+}
+
+void litehtml::display_list::clear()
+{
+	m_items.clear();
+	m_texts.clear();
+	m_text_positions.clear();
+	m_backgrounds.clear();
+	m_borders.clear();
+	m_radiuses.clear();
+	m_open_clips.clear();
+	m_valid = false;
+}
+
+litehtml::display_item& litehtml::display_list::add_item(display_item_type type, const position& pos, int index)
+{
+	display_item item;
+	item.type	= type;
+	item.pos	= pos;
+	item.index	= index;
+	item.end	= -1;
+	item.font	= 0;
+	item.flags	= 0;
+	m_items.push_back(item);
+	return m_items.back();
+}
+
+void litehtml::display_list::add_text(const tchar_t* text, uint_ptr font, web_color color, const position& pos)
+{
+	if(!m_items.empty())
+	{
+		// the words of a line painted one after another become one run
+		display_item& last = m_items.back();
+		if(last.type == display_item_text && last.font == font && same_color(last.color, color) && last.pos.y == pos.y && last.pos.height == pos.height)
+		{
+			int right		= std::max(last.pos.right(), pos.right());
+			last.pos.x		= std::min(last.pos.x, pos.x);
+			last.pos.width	= right - last.pos.x;
+			last.end++;
+			m_texts.push_back(text);
+			m_text_positions.push_back(pos);
+			return;
+		}
+	}
+	display_item& item = add_item(display_item_text, pos, (int) m_texts.size());
+	item.font	= font;
+	item.color	= color;
+	item.end	= 1;
+	m_texts.push_back(text);
+	m_text_positions.push_back(pos);
+}
+
+void litehtml::display_list::add_background(const background_paint& bg)
+{
+	add_item(display_item_background, bg.border_box, (int) m_backgrounds.size());
+	m_backgrounds.push_back(bg);
+}
+
+void litehtml::display_list::add_borders(const borders& brd, const position& draw_pos, bool root)
+{
+	display_item& item = add_item(display_item_borders, draw_pos, (int) m_borders.size());
+	item.flags = root ? item_flag_root : 0;
+	m_borders.push_back(brd);
+}
+
+void litehtml::display_list::add_list_marker(const tstring& image, const tchar_t* baseurl, list_style_type marker_type, web_color color, const position& pos)
+{
+	display_item& item = add_item(display_item_list_marker, pos, (int) m_texts.size());
+	item.color	= color;
+	item.flags	= marker_type;
+	m_texts.push_back(image);
+	m_texts.push_back(baseurl ? baseurl : _t(""));
+	m_text_positions.push_back(pos);
+	m_text_positions.push_back(pos);
+}
+
+void litehtml::display_list::add_set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y)
+{
+	display_item& item = add_item(display_item_set_clip, pos, (int) m_radiuses.size());
+	item.flags = (valid_x ? item_flag_valid_x : 0) | (valid_y ? item_flag_valid_y : 0);
+	m_radiuses.push_back(bdr_radius);
+	m_open_clips.push_back((int) m_items.size() - 1);
+}
+
+void litehtml::display_list::add_del_clip()
+{
+	add_item(display_item_del_clip, position(), -1);
+	if(!m_open_clips.empty())
+	{
+		m_items[m_open_clips.back()].end = (int) m_items.size() - 1;
+		m_open_clips.pop_back();
+	}
+}
@@ -24,13 +24,30 @@
 #include <math.h>
 #include <stdio.h>
 #include <algorithm>
+#include <chrono>
+#include <set>
 #include "gumbo.h"
 #include "utf8_strings.h"
 
 litehtml::document::document(litehtml::document_container* objContainer, litehtml::context* ctx)
 {
-	m_container	= objContainer;
-	m_context	= ctx;
+	m_container		= objContainer;
+	m_context		= ctx;
+	m_lazy_layout	= false;
+	m_defer_layout	= false;
+	m_defer_bottom	= 0;
+	m_record_display_list	= false;
+	m_display_list_width	= -1;
+	m_track_damage			= false;
+	m_hit_index				= true;
+	m_scroll_x				= 0;
+	m_scroll_y				= 0;
+	m_collect_stats			= ctx && ctx->collect_stats();
+	m_profile_selectors		= ctx && ctx->profile_selectors();
+	if(ctx && ctx->get_tracer())
+	{
+		set_tracer(ctx->get_tracer());
+	}
 }
 
 litehtml::document::~document()
@@ -50,13 +67,41 @@ litehtml::document::ptr litehtml::document::createFromString( const tchar_t* str
 	return createFromUTF8(litehtml_to_utf8(str), objPainter, ctx, user_styles);
 }
 
+static long long elapsed_ns(std::chrono::steady_clock::time_point& start, const char* phase = 0)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	long long ret = (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+	if(phase && litehtml::current_tracer)
+	{
+		litehtml::current_tracer->add_span("parse", phase, litehtml::current_tracer->to_trace_time(start), ret, 0, 0, 0);
+	}
+	start = now;
+	return ret;
+}
+
+static void count_elements(const litehtml::element::ptr& el, std::map<litehtml::tstring, int>& elements)
+{
+	const litehtml::tchar_t* tag = el->get_tagName();
+	elements[tag && tag[0] ? tag : _t("#text")]++;
+	for(size_t i = 0; i < el->get_children_count(); i++)
+	{
+		count_elements(el->get_child((int) i), elements);
+	}
+}
+
 litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, litehtml::document_container* objPainter, litehtml::context* ctx, litehtml::css* user_styles)
 {
+	trace_scope trace(ctx ? ctx->get_tracer().get() : 0);
+	trace_span span("parse", "createFromUTF8");
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
 	// parse document into GumboOutput
 	GumboOutput* output = gumbo_parse((const char*) str);
 
 	// Create litehtml::document
 	litehtml::document::ptr doc = std::make_shared<litehtml::document>(objPainter, ctx);
+	stats_scope scope(doc->m_collect_stats ? &doc->m_stats : 0);
+	selector_profile_scope profile(doc->m_profile_selectors ? &doc->m_selector_profile : 0);
 
 	// Create litehtml::elements.
 	elements_vector root_elements;
@@ -67,6 +112,7 @@ litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, lite
 	}
 	// Destroy GumboOutput
 	gumbo_destroy_output(&kGumboDefaultOptions, output);
+	doc->m_stats.creation.parse_html = elapsed_ns(start, "parse_html");
 
 	// Let's process created elements tree
 	if (doc->m_root)
@@ -75,9 +121,11 @@ litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, lite
 
 		// apply master CSS
 		doc->m_root->apply_stylesheet(ctx->master_css());
+		doc->m_stats.creation.apply_stylesheet = elapsed_ns(start, "apply_stylesheet");
 
 		// parse elements attributes
 		doc->m_root->parse_attributes();
+		doc->m_stats.creation.parse_attributes = elapsed_ns(start, "parse_attributes");
 
 		// parse style sheets linked in document
 		media_query_list::ptr media;
@@ -101,6 +149,7 @@ litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, lite
 		{
 			doc->update_media_lists(doc->m_media);
 		}
+		doc->m_stats.creation.parse_css = elapsed_ns(start, "parse_css");
 
 		// Apply parsed styles.
 		doc->m_root->apply_stylesheet(doc->m_styles);
@@ -110,17 +159,26 @@ litehtml::document::ptr litehtml::document::createFromUTF8(const char* str, lite
 		{
 			doc->m_root->apply_stylesheet(*user_styles);
 		}
+		doc->m_stats.creation.apply_stylesheet += elapsed_ns(start, "apply_stylesheet");
 
 		// Parse applied styles in the elements
 		doc->m_root->parse_styles();
+		doc->m_stats.creation.parse_styles = elapsed_ns(start, "parse_styles");
 
 		// Now the m_tabular_elements is filled with tabular elements.
 		// We have to check the tabular elements for missing table elements 
 		// and create the anonymous boxes in visual table layout
 		doc->fix_tables_layout();
+		doc->m_stats.creation.fix_tables = elapsed_ns(start, "fix_tables_layout");
 
 		// Fanaly initialize elements
 		doc->m_root->init();
+		doc->m_stats.creation.init = elapsed_ns(start, "init");
+
+		if (doc->m_collect_stats)
+		{
+			count_elements(doc->m_root, doc->m_stats.elements);
+		}
 	}
 
 	return doc;
@@ -207,6 +265,7 @@ litehtml::uint_ptr litehtml::document::add_font( const tchar_t* name, int size,
 		font_item fi= {0};
 
 		fi.font = m_container->create_font(name, size, fw, fs, decor, &fi.metrics);
+		LITEHTML_STATS_ADD(fonts_created, 1);
 		m_fonts[key] = fi;
 		ret = fi.font;
 		if(fm)
@@ -260,13 +319,33 @@ int litehtml::document::render( int max_width, render_type rt )
 	int ret = 0;
 	if(m_root)
 	{
+		stats_scope scope(m_collect_stats ? &m_stats : 0);
+		trace_scope trace(m_tracer.get());
+		trace_span span("layout", "render");
+		std::chrono::steady_clock::time_point start;
+		if(m_collect_stats)
+		{
+			start = std::chrono::steady_clock::now();
+			m_stats.renders_by_element.clear();
+		}
+		litehtml::size old_size = m_size;
 		if(rt == render_fixed_only)
 		{
 			m_fixed_boxes.clear();
 			m_root->render_positioned(rt);
 		} else
 		{
+			m_pending_layout.clear();
+			if(m_lazy_layout)
+			{
+				// blocks starting below the client rect get estimated heights
+				position client;
+				m_container->get_client_rect(client);
+				m_defer_bottom = client.bottom();
+				m_defer_layout = true;
+			}
 			ret = m_root->render(0, 0, max_width);
+			m_defer_layout = false;
 			if(m_root->fetch_positioned())
 			{
 				m_fixed_boxes.clear();
@@ -275,6 +354,22 @@ int litehtml::document::render( int max_width, render_type rt )
 			m_size.width	= 0;
 			m_size.height	= 0;
 			m_root->calc_document_size(m_size);
+			m_root->calc_ink_overflow();
+		}
+		if(m_track_damage)
+		{
+			update_damage(old_size);
+		}
+		// a render at the same width lays out the same boxes, so the list is kept until draw needs it
+		if(rt != render_all || max_width != m_display_list_width || m_size.width != old_size.width || m_size.height != old_size.height)
+		{
+			m_display_list.clear();
+			m_display_list_width = rt == render_all ? max_width : -1;
+		}
+		if(m_collect_stats)
+		{
+			m_stats.render_time += elapsed_ns(start);
+			m_stats.render_count++;
 		}
 	}
 	return ret;
@@ -284,11 +379,375 @@ void litehtml::document::draw( uint_ptr hdc, int x, int y, const position* clip
 {
 	if(m_root)
 	{
-		m_root->draw(hdc, x, y, clip);
-		m_root->draw_stacking_context(hdc, x, y, clip, true);
+		stats_scope scope(m_collect_stats ? &m_stats : 0);
+		trace_scope trace(m_tracer.get());
+		trace_span span("paint", "draw");
+		std::chrono::steady_clock::time_point start;
+		if(m_collect_stats)
+		{
+			start = std::chrono::steady_clock::now();
+		}
+		if(!m_pending_layout.empty())
+		{
+			if(clip)
+			{
+				position rc = *clip;
+				rc.x -= x;
+				rc.y -= y;
+				realize_layout(&rc);
+			} else
+			{
+				realize_layout();
+			}
+		}
+		if(m_record_display_list && !m_display_list.is_valid())
+		{
+			record_display_list();
+		}
+		if(m_record_display_list && m_display_list.is_valid())
+		{
+			m_display_list.replay(m_container, hdc, x, y, clip);
+		} else
+		{
+			m_root->draw(hdc, x, y, clip);
+			m_root->draw_stacking_context(hdc, x, y, clip, true);
+		}
+		if(m_collect_stats)
+		{
+			m_stats.draw_time += elapsed_ns(start);
+			m_stats.draw_count++;
+		}
+	}
+}
+
+void litehtml::document::record_display_list()
+{
+	m_display_list.clear();
+	// fixed elements are painted relative to the client rect, and pending blocks have no layout yet
+	if(!m_root || !m_fixed_boxes.empty() || !m_pending_layout.empty())
+	{
+		return;
+	}
+	m_display_list.record(m_container, [this](document_container* recorder)
+	{
+		document_container* container = m_container;
+		m_container = recorder;
+		m_root->draw(0, 0, 0, 0);
+		m_root->draw_stacking_context(0, 0, 0, 0, true);
+		m_container = container;
+	});
+}
+
+static void add_tree_memory_usage(const litehtml::element::ptr& el, litehtml::memory_usage& usage)
+{
+	el->add_memory_usage(usage);
+	for(size_t i = 0; i < el->get_children_count(); i++)
+	{
+		add_tree_memory_usage(el->get_child((int) i), usage);
+	}
+}
+
+litehtml::memory_usage litehtml::document::memory_usage() const
+{
+	litehtml::memory_usage usage;
+	if(m_root)
+	{
+		add_tree_memory_usage(m_root, usage);
+	}
+
+	for(fonts_map::const_iterator f = m_fonts.begin(); f != m_fonts.end(); f++)
+	{
+		usage.fonts.add(1, litehtml::memory_usage::map_node_bytes(sizeof(fonts_map::value_type)) + litehtml::memory_usage::string_bytes(f->first));
+	}
+
+	// the rules of a style sheet share their style, the master style sheet belongs to the context
+	std::set<const style*> styles;
+	usage.stylesheets.add(0, m_styles.selectors().capacity() * sizeof(css_selector::ptr) + m_css.capacity() * sizeof(css_text));
+	for(const auto& sel : m_styles.selectors())
+	{
+		usage.stylesheets.add(1, sel->memory_size());
+		if(sel->m_style && styles.insert(sel->m_style.get()).second)
+		{
+			usage.stylesheets.add(0, litehtml::memory_usage::shared_object_bytes(sizeof(style)) + sel->m_style->memory_size());
+		}
+	}
+	for(const auto& css : m_css)
+	{
+		usage.stylesheets.add(0, litehtml::memory_usage::string_bytes(css.text) + litehtml::memory_usage::string_bytes(css.baseurl) + litehtml::memory_usage::string_bytes(css.media));
+	}
+	return usage;
+}
+
+void litehtml::document::set_tracer(const tracer::ptr& tr)
+{
+	if(m_tracing_container)
+	{
+		m_container = m_tracing_container->target();
+		m_tracing_container.reset();
+	}
+	m_tracer = tr;
+	if(m_tracer && m_container)
+	{
+		// the container calls get their own spans
+		m_tracing_container.reset(new tracing_container(m_container));
+		m_container = m_tracing_container.get();
 	}
 }
 
+static void unite_boxes(litehtml::position& box, const litehtml::position& pos)
+{
+	int right	= std::max(box.right(), pos.right());
+	int bottom	= std::max(box.bottom(), pos.bottom());
+	box.x		= std::min(box.x, pos.x);
+	box.y		= std::min(box.y, pos.y);
+	box.width	= right - box.x;
+	box.height	= bottom - box.y;
+}
+
+bool litehtml::document::find_styles_changes( position::vector& redraw_boxes )
+{
+	stats_scope scope(m_collect_stats ? &m_stats : 0);
+	selector_profile_scope profile(m_profile_selectors ? &m_selector_profile : 0);
+	trace_scope trace(m_tracer.get());
+	trace_span span("style", "find_styles_changes");
+	size_t first = redraw_boxes.size();
+	bool ret = m_root->find_styles_changes(redraw_boxes, 0, 0);
+	if(m_track_damage)
+	{
+		for(size_t i = first; i < redraw_boxes.size(); i++)
+		{
+			add_damage(redraw_boxes[i]);
+		}
+	}
+	return ret;
+}
+
+void litehtml::document::take_damage( position::vector& damage )
+{
+	damage.clear();
+	damage.swap(m_damage);
+}
+
+void litehtml::document::update_damage( const litehtml::size& old_size )
+{
+	std::vector<std::pair<const element*, position>> boxes;
+	boxes.reserve(m_damage_boxes.size());
+	get_damage_boxes(m_root, 0, 0, boxes);
+
+	bool whole = boxes.size() != m_damage_boxes.size();
+	for(size_t i = 0; i < boxes.size() && !whole; i++)
+	{
+		if(boxes[i].first != m_damage_boxes[i].first)
+		{
+			whole = true;
+		} else
+		{
+			const position& old_box = m_damage_boxes[i].second;
+			const position& new_box = boxes[i].second;
+			if(old_box.x != new_box.x || old_box.y != new_box.y || old_box.width != new_box.width || old_box.height != new_box.height)
+			{
+				add_damage(old_box);
+				add_damage(new_box);
+			}
+		}
+	}
+	if(whole)
+	{
+		// the first render or a changed tree, nothing to compare with
+		m_damage.clear();
+		add_damage(position(0, 0, std::max(old_size.width, m_size.width), std::max(old_size.height, m_size.height)));
+	}
+	m_damage_boxes.swap(boxes);
+}
+
+void litehtml::document::get_damage_boxes( const element::ptr& el, int x, int y, std::vector<std::pair<const element*, position>>& boxes )
+{
+	// the same boxes find_styles_changes reports, fixed elements are in the client coordinates
+	if(el->get_element_position() == element_position_fixed)
+	{
+		x = 0;
+		y = 0;
+	}
+	position box;
+	if(el->is_visible())
+	{
+		style_display display = el->get_display();
+		if(display == display_inline || display == display_table_row)
+		{
+			position::vector inline_boxes;
+			el->get_inline_boxes(inline_boxes);
+			for(position::vector::iterator pos = inline_boxes.begin(); pos != inline_boxes.end(); pos++)
+			{
+				position inline_box = *pos;
+				inline_box.x += x;
+				inline_box.y += y;
+				if(box.empty())
+				{
+					box = inline_box;
+				} else
+				{
+					unite_boxes(box, inline_box);
+				}
+			}
+		} else
+		{
+			box = el->m_pos;
+			box.x += x;
+			box.y += y;
+			box += el->m_padding;
+			box += el->m_borders;
+		}
+	}
+	boxes.push_back(std::make_pair(el.get(), box));
+
+	for(elements_vector::iterator i = el->m_children.begin(); i != el->m_children.end(); i++)
+	{
+		get_damage_boxes(*i, x + el->m_pos.x, y + el->m_pos.y, boxes);
+	}
+}
+
+void litehtml::document::add_damage( const position& pos )
+{
+	if(pos.empty())
+	{
+		return;
+	}
+	// the boxes overlapping the new one are merged in one pass, so the list stays short
+	position box = pos;
+	size_t count = 0;
+	for(size_t i = 0; i < m_damage.size(); i++)
+	{
+		if(m_damage[i].does_intersect(&box))
+		{
+			unite_boxes(box, m_damage[i]);
+		} else
+		{
+			m_damage[count++] = m_damage[i];
+		}
+	}
+	m_damage.resize(count);
+	// many small boxes cost the host more than their bounding box
+	const size_t max_damage = 32;
+	if(m_damage.size() >= max_damage)
+	{
+		for(const auto& damage : m_damage)
+		{
+			unite_boxes(box, damage);
+		}
+		m_damage.clear();
+	}
+	m_damage.push_back(box);
+}
+
+void litehtml::document::run_tasks( int count, const std::function<void(int)>& task )
+{
+	if(m_executor && count > 1)
+	{
+		tracer* tr = current_tracer;
+#ifndef LITEHTML_NO_STATS
+		if(current_stats)
+		{
+			// every task counts into its own stats, they are added up when all are done
+			std::vector<document_stats> task_stats(count);
+			m_executor->run(count, [&](int i)
+			{
+				stats_scope scope(&task_stats[i]);
+				trace_scope trace(tr);
+				task(i);
+			});
+			for(int i = 0; i < count; i++)
+			{
+				current_stats->add_counters(task_stats[i]);
+			}
+			return;
+		}
+#endif
+		m_executor->run(count, [&](int i)
+		{
+			trace_scope trace(tr);
+			task(i);
+		});
+	} else
+	{
+		for(int i = 0; i < count; i++)
+		{
+			task(i);
+		}
+	}
+}
+
+bool litehtml::document::realize_layout( const position* rect )
+{
+	bool ret = false;
+	if(!m_root)
+	{
+		return ret;
+	}
+	stats_scope scope(m_collect_stats ? &m_stats : 0);
+	trace_scope trace(m_tracer.get());
+	trace_span span("layout", "realize_layout");
+	// pending blocks are stored in document order, so their tops only grow
+	size_t pending = 0;
+	litehtml::size old_size = m_size;
+	int damage_top = INT_MAX;
+	for(size_t i = 0; i < m_pending_layout.size(); i++)
+	{
+		const element::ptr& el = m_pending_layout[i];
+		if(!el->is_layout_pending())
+		{
+			continue;
+		}
+		if(rect)
+		{
+			position pos = el->get_placement();
+			if(pos.top() > rect->bottom())
+			{
+				// the rest of the blocks are below the rect
+				for(; i < m_pending_layout.size(); i++)
+				{
+					m_pending_layout[pending++] = m_pending_layout[i];
+				}
+				break;
+			}
+			if(pos.bottom() < rect->top())
+			{
+				m_pending_layout[pending++] = el;
+				continue;
+			}
+		}
+		if(m_track_damage && damage_top == INT_MAX)
+		{
+			damage_top = el->get_placement().top() - el->padding_top() - el->border_top();
+		}
+		el->realize_layout();
+		// the realized subtree is measured again, the ancestors only from their children
+		size el_size;
+		el->calc_document_size(el_size);
+		el->calc_ink_overflow();
+		for(element::ptr el_parent = el->parent(); el_parent; el_parent = el_parent->parent())
+		{
+			el_parent->update_overflow();
+		}
+		ret = true;
+	}
+	m_pending_layout.resize(pending);
+	if(ret)
+	{
+		m_display_list.clear();
+		// estimated sizes were corrected, so correct the scroll extent too
+		m_size.width	= std::max(0, m_root->m_doc_extent.width);
+		m_size.height	= std::max(0, m_root->m_doc_extent.height);
+		if(m_track_damage)
+		{
+			// the first realized block and everything below it may have moved
+			add_damage(position(0, damage_top, std::max(old_size.width, m_size.width), std::max(old_size.height, m_size.height) - damage_top));
+			m_damage_boxes.clear();
+			get_damage_boxes(m_root, 0, 0, m_damage_boxes);
+		}
+	}
+	return ret;
+}
+
 int litehtml::document::cvt_units( const tchar_t* str, int fontSize, bool* is_percent/*= 0*/ ) const
 {
 	if(!str)	return 0;
@@ -382,6 +841,11 @@ bool litehtml::document::on_mouse_over( int x, int y, int client_x, int client_y
 		return false;
 	}
 
+	if(!m_pending_layout.empty())
+	{
+		position pt(x, y, 1, 1);
+		realize_layout(&pt);
+	}
 	element::ptr over_el = m_root->get_element_by_point(x, y, client_x, client_y);
 
 	bool state_was_changed = false;
@@ -413,7 +877,8 @@ bool litehtml::document::on_mouse_over( int x, int y, int client_x, int client_y
 	
 	if(state_was_changed)
 	{
-		return m_root->find_styles_changes(redraw_boxes, 0, 0);
+		m_display_list.clear();
+		return find_styles_changes(redraw_boxes);
 	}
 	return false;
 }
@@ -428,7 +893,8 @@ bool litehtml::document::on_mouse_leave( position::vector& redraw_boxes )
 	{
 		if(m_over_element->on_mouse_leave())
 		{
-			return m_root->find_styles_changes(redraw_boxes, 0, 0);
+			m_display_list.clear();
+			return find_styles_changes(redraw_boxes);
 		}
 	}
 	return false;
@@ -441,6 +907,11 @@ bool litehtml::document::on_lbutton_down( int x, int y, int client_x, int client
 		return false;
 	}
 
+	if(!m_pending_layout.empty())
+	{
+		position pt(x, y, 1, 1);
+		realize_layout(&pt);
+	}
 	element::ptr over_el = m_root->get_element_by_point(x, y, client_x, client_y);
 
 	bool state_was_changed = false;
@@ -479,7 +950,8 @@ bool litehtml::document::on_lbutton_down( int x, int y, int client_x, int client
 
 	if(state_was_changed)
 	{
-		return m_root->find_styles_changes(redraw_boxes, 0, 0);
+		m_display_list.clear();
+		return find_styles_changes(redraw_boxes);
 	}
 
 	return false;
@@ -495,7 +967,8 @@ bool litehtml::document::on_lbutton_up( int x, int y, int client_x, int client_y
 	{
 		if(m_over_element->on_lbutton_up())
 		{
-			return m_root->find_styles_changes(redraw_boxes, 0, 0);
+			m_display_list.clear();
+			return find_styles_changes(redraw_boxes);
 		}
 	}
 	return false;
@@ -584,6 +1057,54 @@ void litehtml::document::add_fixed_box( const position& pos )
 	m_fixed_boxes.push_back(pos);
 }
 
+bool litehtml::document::scroll_to( int x, int y, position::vector& redraw_boxes )
+{
+	int dx = x - m_scroll_x;
+	int dy = y - m_scroll_y;
+	m_scroll_x = x;
+	m_scroll_y = y;
+	if(!m_root || (!dx && !dy))
+	{
+		return false;
+	}
+
+	// the boxes are in the client coordinates, the rest of the client rect can be moved by (-dx, -dy)
+	position client;
+	m_container->get_client_rect(client);
+	if(std::abs(dx) >= client.width || std::abs(dy) >= client.height)
+	{
+		redraw_boxes.push_back(client);
+	} else
+	{
+		if(dy > 0)
+		{
+			redraw_boxes.push_back(position(client.x, client.bottom() - dy, client.width, dy));
+		} else if(dy < 0)
+		{
+			redraw_boxes.push_back(position(client.x, client.y, client.width, -dy));
+		}
+		if(dx > 0)
+		{
+			redraw_boxes.push_back(position(client.right() - dx, client.y, dx, client.height));
+		} else if(dx < 0)
+		{
+			redraw_boxes.push_back(position(client.x, client.y, -dx, client.height));
+		}
+	}
+
+	if(!m_fixed_boxes.empty())
+	{
+		// fixed elements are placed in the client rect, so scrolling does not move them and no
+		// layout is needed: only their place and the copy moved with the content are damaged
+		for(position::vector::iterator box = m_fixed_boxes.begin(); box != m_fixed_boxes.end(); box++)
+		{
+			redraw_boxes.push_back(*box);
+			redraw_boxes.push_back(position(box->x - dx, box->y - dy, box->width, box->height));
+		}
+	}
+	return true;
+}
+
 bool litehtml::document::media_changed()
 {
 	if(!m_media_lists.empty())
@@ -591,8 +1112,10 @@ bool litehtml::document::media_changed()
 		container()->get_media_features(m_media);
 		if (update_media_lists(m_media))
 		{
+			selector_profile_scope profile(m_profile_selectors ? &m_selector_profile : 0);
 			m_root->refresh_styles();
 			m_root->parse_styles();
+			m_display_list.clear();
 			return true;
 		}
 	}
@@ -613,8 +1136,10 @@ bool litehtml::document::lang_changed()
 		{
 			m_culture.clear();
 		}
+		selector_profile_scope profile(m_profile_selectors ? &m_selector_profile : 0);
 		m_root->refresh_styles();
 		m_root->parse_styles();
+		m_display_list.clear();
 		return true;
 	}
 	return false;
@@ -806,10 +1331,25 @@ void litehtml::document::fix_tables_layout()
 		case display_table_cell:
 			fix_table_parent(el_ptr, display_table_row, _t("table-row"));
 			break;
-		// TODO: make table layout fix for table-caption, table-column etc. elements
 		case display_table_caption:
-		case display_table_column:
 		case display_table_column_group:
+			{
+				element::ptr parent = el_ptr->parent();
+				if (parent && parent->get_display() != display_table && parent->get_display() != display_inline_table)
+				{
+					fix_table_parent(el_ptr, display_table, _t("table"));
+				}
+			}
+			break;
+		case display_table_column:
+			{
+				element::ptr parent = el_ptr->parent();
+				if (parent && parent->get_display() != display_table && parent->get_display() != display_inline_table && parent->get_display() != display_table_column_group)
+				{
+					fix_table_parent(el_ptr, display_table, _t("table"));
+				}
+			}
+			break;
 		default:
 			break;
 		}
@@ -817,11 +1357,55 @@ void litehtml::document::fix_tables_layout()
 	}
 }
 
+static bool is_proper_table_child(litehtml::style_display parent_disp, litehtml::style_display disp)
+{
+	switch (parent_disp)
+	{
+	case litehtml::display_table_row_group:
+		// the table keeps its captions, columns and all kinds of row groups
+		return	disp == litehtml::display_table_row_group ||
+				disp == litehtml::display_table_header_group ||
+				disp == litehtml::display_table_footer_group ||
+				disp == litehtml::display_table_caption ||
+				disp == litehtml::display_table_column ||
+				disp == litehtml::display_table_column_group;
+	case litehtml::display_table_row:
+	case litehtml::display_table_cell:
+		return disp == parent_disp;
+	default:
+		return false;
+	}
+}
+
+static bool is_table_part(litehtml::style_display parent_disp, litehtml::style_display disp)
+{
+	// the elements that end up inside an anonymous parent with parent_disp
+	switch (parent_disp)
+	{
+	case litehtml::display_table:
+		return	disp == litehtml::display_table_row_group ||
+				disp == litehtml::display_table_header_group ||
+				disp == litehtml::display_table_footer_group ||
+				disp == litehtml::display_table_caption ||
+				disp == litehtml::display_table_column ||
+				disp == litehtml::display_table_column_group ||
+				disp == litehtml::display_table_row ||
+				disp == litehtml::display_table_cell;
+	case litehtml::display_table_row_group:
+		return disp == litehtml::display_table_row || disp == litehtml::display_table_cell;
+	case litehtml::display_table_row:
+		return disp == litehtml::display_table_cell;
+	default:
+		return false;
+	}
+}
+
 void litehtml::document::fix_table_children(element::ptr& el_ptr, style_display disp, const tchar_t* disp_str)
 {
+	// the new children are collected into a fresh vector, so every child is moved only once
+	elements_vector children;
 	elements_vector tmp;
-	elements_vector::iterator first_iter = el_ptr->m_children.begin();
-	elements_vector::iterator cur_iter = el_ptr->m_children.begin();
+	bool changed = false;
 
 	auto flush_elements = [&]()
 	{
@@ -831,121 +1415,115 @@ void litehtml::document::fix_table_children(element::ptr& el_ptr, style_display
 		annon_tag->add_style(st);
 		annon_tag->parent(el_ptr);
 		annon_tag->parse_styles();
-		std::for_each(tmp.begin(), tmp.end(),
-			[&annon_tag](element::ptr& el)
-			{
-				annon_tag->appendChild(el);
-			}
-		);
-		first_iter = el_ptr->m_children.insert(first_iter, annon_tag);
-		cur_iter = first_iter + 1;
-		while (cur_iter != el_ptr->m_children.end() && (*cur_iter)->parent() != el_ptr)
+		for (auto& el : tmp)
 		{
-			cur_iter = el_ptr->m_children.erase(cur_iter);
+			annon_tag->appendChild(el);
 		}
-		first_iter = cur_iter;
+		children.push_back(annon_tag);
 		tmp.clear();
+		changed = true;
 	};
 
-	while (cur_iter != el_ptr->m_children.end())
+	children.reserve(el_ptr->m_children.size());
+	for (auto& el : el_ptr->m_children)
 	{
-		if ((*cur_iter)->get_display() != disp)
+		if (!is_proper_table_child(disp, el->get_display()))
 		{
-			if (!(*cur_iter)->is_white_space() || ((*cur_iter)->is_white_space() && !tmp.empty()))
+			if (!el->is_white_space() || !tmp.empty())
 			{
-				if (tmp.empty())
-				{
-					first_iter = cur_iter;
-				}
-				tmp.push_back((*cur_iter));
+				tmp.push_back(el);
+			}
+			else
+			{
+				children.push_back(el);
 			}
-			cur_iter++;
-		}
-		else if (!tmp.empty())
-		{
-			flush_elements();
 		}
 		else
 		{
-			cur_iter++;
+			if (!tmp.empty())
+			{
+				flush_elements();
+			}
+			children.push_back(el);
 		}
 	}
 	if (!tmp.empty())
 	{
 		flush_elements();
 	}
+	if (changed)
+	{
+		el_ptr->m_children.swap(children);
+		el_ptr->m_child_index_valid = false;
+		el_ptr->update_estimate();
+	}
 }
 
 void litehtml::document::fix_table_parent(element::ptr& el_ptr, style_display disp, const tchar_t* disp_str)
 {
 	element::ptr parent = el_ptr->parent();
 
-	if (parent->get_display() != disp)
+	if (parent->get_display() == disp)
 	{
-		elements_vector::iterator this_element = std::find_if(parent->m_children.begin(), parent->m_children.end(),
-			[&](element::ptr& el)
-			{
-				if (el == el_ptr)
-				{
-					return true;
-				}
-				return false;
-			}
-		);
-		if (this_element != parent->m_children.end())
-		{
-			style_display el_disp = el_ptr->get_display();
-			elements_vector::iterator first = this_element;
-			elements_vector::iterator last = this_element;
-			elements_vector::iterator cur = this_element;
-
-			// find first element with same display
-			while (true)
-			{
-				if (cur == parent->m_children.begin()) break;
-				cur--;
-				if ((*cur)->is_white_space() || (*cur)->get_display() == el_disp)
-				{
-					first = cur;
-				}
-				else
-				{
-					break;
-				}
-			}
-
-			// find last element with same display
-			cur = this_element;
-			while (true)
-			{
-				cur++;
-				if (cur == parent->m_children.end()) break;
+		return;
+	}
 
-				if ((*cur)->is_white_space() || (*cur)->get_display() == el_disp)
-				{
-					last = cur;
-				}
-				else
-				{
-					break;
-				}
-			}
+	// every run of table parts holding an element with the display of el_ptr is wrapped
+	// with an anonymous object in one pass, so the siblings of el_ptr are fixed here as well
+	style_display el_disp = el_ptr->get_display();
+	elements_vector children;
+	elements_vector run;
+	bool run_found = false;
+	bool changed = false;
 
-			// extract elements with the same display and wrap them with anonymous object
+	auto flush_run = [&]()
+	{
+		if (run_found)
+		{
 			element::ptr annon_tag = std::make_shared<html_tag>(shared_from_this());
 			style st;
 			st.add_property(_t("display"), disp_str, 0, false);
 			annon_tag->add_style(st);
 			annon_tag->parent(parent);
 			annon_tag->parse_styles();
-			std::for_each(first, last + 1,
-				[&annon_tag](element::ptr& el)
-				{
-					annon_tag->appendChild(el);
-				}
-			);
-			first = parent->m_children.erase(first, last + 1);
-			parent->m_children.insert(first, annon_tag);
+			for (auto& el : run)
+			{
+				annon_tag->appendChild(el);
+			}
+			children.push_back(annon_tag);
+			changed = true;
+		}
+		else
+		{
+			children.insert(children.end(), run.begin(), run.end());
+		}
+		run.clear();
+		run_found = false;
+	};
+
+	children.reserve(parent->m_children.size());
+	for (auto& el : parent->m_children)
+	{
+		if (el->get_display() == el_disp)
+		{
+			run.push_back(el);
+			run_found = true;
 		}
+		else if (el->is_white_space() || is_table_part(disp, el->get_display()))
+		{
+			run.push_back(el);
+		}
+		else
+		{
+			flush_run();
+			children.push_back(el);
+		}
+	}
+	flush_run();
+	if (changed)
+	{
+		parent->m_children.swap(children);
+		parent->m_child_index_valid = false;
+		parent->update_estimate();
 	}
 }
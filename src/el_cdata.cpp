@@ -1,5 +1,6 @@
 #include "html.h"
 #include "el_cdata.h"
+#include "stats.h"
 
 litehtml::el_cdata::el_cdata(const std::shared_ptr<litehtml::document>& doc) : litehtml::element(doc)
 {
@@ -23,3 +24,9 @@ void litehtml::el_cdata::set_data( const tchar_t* data )
 		m_text += data;
 	}
 }
+
+void litehtml::el_cdata::add_memory_usage(memory_usage& usage) const
+{
+	add_element_usage(usage, _t("#cdata"), sizeof(el_cdata));
+	usage.texts.add(1, memory_usage::string_bytes(m_text));
+}
@@ -56,7 +56,10 @@ int litehtml::el_image::render( int x, int y, int max_width, bool second_pass )
 	document::ptr doc = get_document();
 
 	litehtml::size sz;
-	doc->container()->get_image_size(m_src.c_str(), 0, sz);
+	{
+		auto lock = doc->lock_container();
+		doc->container()->get_image_size(m_src.c_str(), 0, sz);
+	}
 
 	m_pos.width		= sz.width;
 	m_pos.height	= sz.height;
@@ -271,3 +274,9 @@ void litehtml::el_image::parse_styles( bool is_reparse /*= false*/ )
 		}
 	}
 }
+
+void litehtml::el_image::add_memory_usage(memory_usage& usage) const
+{
+	add_tag_usage(usage, sizeof(el_image));
+	usage.attributes.add(1, memory_usage::string_bytes(m_src));
+}
@@ -28,3 +28,9 @@ const litehtml::tchar_t* litehtml::el_script::get_tagName() const
 {
 	return _t("script");
 }
+
+void litehtml::el_script::add_memory_usage(memory_usage& usage) const
+{
+	add_element_usage(usage, get_tagName(), sizeof(el_script));
+	usage.texts.add(1, memory_usage::string_bytes(m_text));
+}
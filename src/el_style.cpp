@@ -34,3 +34,13 @@ const litehtml::tchar_t* litehtml::el_style::get_tagName() const
 {
 	return _t("style");
 }
+
+void litehtml::el_style::add_memory_usage(memory_usage& usage) const
+{
+	// the text nodes are kept here only, they are not children of the tree
+	add_element_usage(usage, get_tagName(), sizeof(el_style)).bytes += m_children.capacity() * sizeof(element::ptr);
+	for(const auto& el : m_children)
+	{
+		el->add_memory_usage(usage);
+	}
+}
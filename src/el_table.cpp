@@ -10,6 +10,7 @@ litehtml::el_table::el_table(const std::shared_ptr<litehtml::document>& doc) : h
 	m_border_spacing_x	= 0;
 	m_border_spacing_y	= 0;
 	m_border_collapse	= border_collapse_separate;
+	m_table_layout		= table_layout_auto;
 }
 
 
@@ -33,6 +34,7 @@ void litehtml::el_table::parse_styles(bool is_reparse)
 	html_tag::parse_styles(is_reparse);
 
 	m_border_collapse = (border_collapse) value_index(get_style_property(_t("border-collapse"), true, _t("separate")), border_collapse_strings, border_collapse_separate);
+	m_table_layout = (table_layout) value_index(get_style_property(_t("table-layout"), false, _t("auto")), table_layout_strings, table_layout_auto);
 
 	if(m_border_collapse == border_collapse_separate)
 	{
@@ -28,6 +28,16 @@ void litehtml::el_text::get_text( tstring& text )
 	text += m_text;
 }
 
+const litehtml::tchar_t* litehtml::el_text::get_draw_text() const
+{
+	return m_use_transformed ? m_transformed_text.c_str() : m_text.c_str();
+}
+
+void litehtml::el_text::set_text_width( int width )
+{
+	m_size.width = width;
+}
+
 const litehtml::tchar_t* litehtml::el_text::get_style_property( const tchar_t* name, bool inherited, const tchar_t* def /*= 0*/ )
 {
 	if(inherited)
@@ -43,6 +53,7 @@ const litehtml::tchar_t* litehtml::el_text::get_style_property( const tchar_t* n
 
 void litehtml::el_text::parse_styles(bool is_reparse)
 {
+	int old_width = m_size.width;
 	m_text_transform	= (text_transform)	value_index(get_style_property(_t("text-transform"), true,	_t("none")),	text_transform_strings,	text_transform_none);
 	if(m_text_transform != text_transform_none)
 	{
@@ -69,6 +80,8 @@ void litehtml::el_text::parse_styles(bool is_reparse)
 		}
 	}
 
+	// the width is measured by the parent in one batch (see html_tag::measure_text_children),
+	// unless the text is parsed on its own
 	font_metrics fm;
 	uint_ptr font = 0;
 	element::ptr el_parent = parent();
@@ -76,14 +89,22 @@ void litehtml::el_text::parse_styles(bool is_reparse)
 	{
 		font = el_parent->get_font(&fm);
 	}
-	if(is_break())
-	{
-		m_size.height	= 0;
-		m_size.width	= 0;
-	} else
+	m_size.width	= 0;
+	m_size.height	= is_break() ? 0 : fm.height;
+	if (!el_parent || !el_parent->is_measuring_text())
 	{
-		m_size.height	= fm.height;
-		m_size.width	= get_document()->container()->text_width(m_use_transformed ? m_transformed_text.c_str() : m_text.c_str(), font);
+		if (!is_break())
+		{
+			m_size.width = get_document()->container()->text_width(get_draw_text(), font);
+			LITEHTML_STATS_ADD(text_width_calls, 1);
+		}
+		if (el_parent && m_size.width != old_width)
+		{
+			// the new width is a change of the inline content of the parent
+			content_estimate delta;
+			delta.inline_width = m_size.width - old_width;
+			el_parent->add_child_estimate(delta);
+		}
 	}
 	m_draw_spaces = fm.draw_spaces;
 }
@@ -117,8 +138,8 @@ void litehtml::el_text::draw( uint_ptr hdc, int x, int y, const position* clip )
 			document::ptr doc = get_document();
 
 			uint_ptr font = el_parent->get_font();
-			litehtml::web_color color = el_parent->get_color(_t("color"), true, doc->get_def_color());
-			doc->container()->draw_text(hdc, m_use_transformed ? m_transformed_text.c_str() : m_text.c_str(), font, color, pos);
+			litehtml::web_color color = el_parent->get_text_color(doc->get_def_color());
+			doc->container()->draw_text(hdc, get_draw_text(), font, color, pos);
 		}
 	}
 }
@@ -186,3 +207,13 @@ litehtml::css_offsets litehtml::el_text::get_css_offsets() const
 	}
 	return css_offsets();
 }
+
+void litehtml::el_text::add_memory_usage(memory_usage& usage) const
+{
+	add_element_usage(usage, _t("#text"), sizeof(el_text));
+	usage.texts.add(1, memory_usage::string_bytes(m_text));
+	if(!m_transformed_text.empty())
+	{
+		usage.transformed_texts.add(1, memory_usage::string_bytes(m_transformed_text));
+	}
+}
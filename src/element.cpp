@@ -9,6 +9,12 @@ litehtml::element::element(const std::shared_ptr<litehtml::document>& doc) : m_d
 {
 	m_box		= 0;
 	m_skip		= false;
+	// nothing is culled until the first layout
+	m_ink_bounded	= false;
+	m_child_index		= 0;
+	m_type_index		= 0;
+	m_type_count		= 0;
+	m_child_index_valid	= false;
 }
 
 litehtml::element::~element()
@@ -69,6 +75,26 @@ litehtml::position litehtml::element::get_placement() const
 	return pos;
 }
 
+void litehtml::element::estimate_content(content_estimate& est)
+{
+	size sz;
+	get_content_size(sz, 0);
+	est.inline_width += sz.width;
+}
+
+void litehtml::element::add_memory_usage(memory_usage& usage) const
+{
+	const tchar_t* tag = get_tagName();
+	add_element_usage(usage, tag && tag[0] ? tag : _t("#element"), sizeof(element));
+}
+
+litehtml::memory_item& litehtml::element::add_element_usage(memory_usage& usage, const tchar_t* type, size_t object_size) const
+{
+	memory_item& item = usage.elements[type];
+	item.add(1, memory_usage::shared_object_bytes(object_size) + m_children.capacity() * sizeof(element::ptr));
+	return item;
+}
+
 bool litehtml::element::is_inline_box() const
 {
 	style_display d = get_display();
@@ -141,10 +167,12 @@ bool litehtml::element::get_predefined_height(int& p_height) const
 
 void litehtml::element::calc_document_size( litehtml::size& sz, int x /*= 0*/, int y /*= 0*/ )
 {
+	m_doc_extent.width	= right();
+	m_doc_extent.height	= bottom();
 	if(is_visible())
 	{
-		sz.width	= std::max(sz.width,	x + right());
-		sz.height	= std::max(sz.height,	y + bottom());
+		sz.width	= std::max(sz.width,	x + m_doc_extent.width);
+		sz.height	= std::max(sz.height,	y + m_doc_extent.height);
 	}
 }
 
@@ -164,6 +192,15 @@ void litehtml::element::get_redraw_box(litehtml::position& pos, int x /*= 0*/, i
 	}
 }
 
+void litehtml::element::calc_ink_overflow()
+{
+	m_ink_overflow = m_pos;
+	m_ink_overflow += m_padding;
+	m_ink_overflow += m_borders;
+	// fixed elements are painted relative to the client rect
+	m_ink_bounded = get_element_position() != element_position_fixed;
+}
+
 int litehtml::element::calc_width(int defVal) const
 {
 	css_length w = get_css_width();
@@ -329,7 +366,15 @@ bool litehtml::element::is_nth_child(const element::ptr&, int num, int off, bool
 bool litehtml::element::is_only_child(const element::ptr& el, bool of_type)	 const	LITEHTML_RETURN_FUNC(false)
 litehtml::overflow litehtml::element::get_overflow() const							LITEHTML_RETURN_FUNC(overflow_visible)
 void litehtml::element::draw_children( uint_ptr hdc, int x, int y, const position* clip, draw_flag flag, int zindex ) LITEHTML_EMPTY_FUNC
+int litehtml::element::get_defer_top() const										LITEHTML_RETURN_FUNC(-1)
+bool litehtml::element::is_layout_pending() const									LITEHTML_RETURN_FUNC(false)
+int litehtml::element::realize_layout()												LITEHTML_RETURN_FUNC(0)
+void litehtml::element::update_child_height(const element::ptr& el, int dy, int old_margin) LITEHTML_EMPTY_FUNC
+void litehtml::element::update_overflow()											LITEHTML_EMPTY_FUNC
+void litehtml::element::add_child_estimate(const content_estimate& delta)			LITEHTML_EMPTY_FUNC
+void litehtml::element::update_estimate()											LITEHTML_EMPTY_FUNC
 void litehtml::element::draw_stacking_context( uint_ptr hdc, int x, int y, const position* clip, bool with_positioned ) LITEHTML_EMPTY_FUNC
+bool litehtml::element::set_children_clip(int x, int y)									LITEHTML_RETURN_FUNC(false)
 void litehtml::element::render_positioned(render_type rt)							LITEHTML_EMPTY_FUNC
 int litehtml::element::get_zindex() const											LITEHTML_RETURN_FUNC(0)
 bool litehtml::element::fetch_positioned()											LITEHTML_RETURN_FUNC(false)
@@ -340,6 +385,7 @@ litehtml::element::ptr litehtml::element::get_child( int idx ) const				LITEHTML
 size_t litehtml::element::get_children_count() const								LITEHTML_RETURN_FUNC(0)
 void litehtml::element::calc_outlines( int parent_width )							LITEHTML_EMPTY_FUNC
 litehtml::css_length litehtml::element::get_css_width() const						LITEHTML_RETURN_FUNC(css_length())
+litehtml::box_sizing litehtml::element::get_box_sizing() const						LITEHTML_RETURN_FUNC(box_sizing_content_box)
 litehtml::css_length litehtml::element::get_css_height() const						LITEHTML_RETURN_FUNC(css_length())
 litehtml::element_clear litehtml::element::get_clear() const						LITEHTML_RETURN_FUNC(clear_none)
 litehtml::css_length litehtml::element::get_css_left() const						LITEHTML_RETURN_FUNC(css_length())
@@ -400,7 +446,11 @@ void litehtml::element::draw_background( uint_ptr hdc, int x, int y, const posit
 const litehtml::tchar_t* litehtml::element::get_style_property( const tchar_t* name, bool inherited, const tchar_t* def /*= 0*/ )	LITEHTML_RETURN_FUNC(0)
 litehtml::uint_ptr litehtml::element::get_font( font_metrics* fm /*= 0*/ )			LITEHTML_RETURN_FUNC(0)
 int litehtml::element::get_font_size()	const										LITEHTML_RETURN_FUNC(0)
+litehtml::web_color litehtml::element::get_text_color(const web_color& def_color) const	LITEHTML_RETURN_FUNC(def_color)
 void litehtml::element::get_text( tstring& text )									LITEHTML_EMPTY_FUNC
+const litehtml::tchar_t* litehtml::element::get_draw_text() const					LITEHTML_RETURN_FUNC(0)
+void litehtml::element::set_text_width( int width )									LITEHTML_EMPTY_FUNC
+bool litehtml::element::is_measuring_text() const									LITEHTML_RETURN_FUNC(false)
 void litehtml::element::parse_attributes()											LITEHTML_EMPTY_FUNC
 int litehtml::element::select( const css_selector& selector, bool apply_pseudo)		LITEHTML_RETURN_FUNC(select_no_match)
 int litehtml::element::select( const css_element_selector& selector, bool apply_pseudo /*= true*/ )	LITEHTML_RETURN_FUNC(select_no_match)
@@ -0,0 +1,169 @@
+#include "html.h"
+#include "executor.h"
+
+namespace
+{
+	// the pool and the worker index of the current thread
+	thread_local litehtml::thread_pool_executor*	t_pool	= 0;
+	thread_local int								t_index	= -1;
+}
+
+struct litehtml::thread_pool_executor::batch
+{
+	const std::function<void(int)>*	task;
+	std::atomic<int>				pending;
+};
+
+litehtml::thread_pool_executor::thread_pool_executor(int threads_count) : m_queued(0), m_next(0), m_stop(false)
+{
+	if (threads_count <= 0)
+	{
+		threads_count = (int) std::thread::hardware_concurrency();
+	}
+	// the thread calling run() works too
+	for (int i = 1; i < threads_count; i++)
+	{
+		m_workers.push_back(std::unique_ptr<worker>(new worker()));
+	}
+	for (int i = 0; i < (int) m_workers.size(); i++)
+	{
+		m_workers[i]->thread = std::thread(&thread_pool_executor::worker_proc, this, i);
+	}
+}
+
+litehtml::thread_pool_executor::~thread_pool_executor()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wait_lock);
+		m_stop = true;
+	}
+	m_wait_cond.notify_all();
+	for (auto& w : m_workers)
+	{
+		w->thread.join();
+	}
+}
+
+void litehtml::thread_pool_executor::run(int count, const std::function<void(int)>& task)
+{
+	if (m_workers.empty() || count <= 1)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	int index = t_pool == this ? t_index : -1;
+	int chunks = std::min(count, threads_count() * 4);
+
+	batch b;
+	b.task		= &task;
+	b.pending	= chunks;
+
+	for (int i = 0; i < chunks; i++)
+	{
+		job jb;
+		jb.owner	= &b;
+		jb.begin	= (int) ((long long) count * i / chunks);
+		jb.end		= (int) ((long long) count * (i + 1) / chunks);
+
+		// workers keep nested jobs for themselves, the others are spread over the pool
+		worker& w = *m_workers[index >= 0 ? index : m_next++ % m_workers.size()];
+		std::lock_guard<std::mutex> lock(w.lock);
+		w.jobs.push_back(jb);
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wait_lock);
+		m_queued += chunks;
+	}
+	m_wait_cond.notify_all();
+
+	// help with any queued job until this batch is done
+	while (b.pending > 0)
+	{
+		job jb;
+		if (take_job(index, jb))
+		{
+			execute(jb);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_wait_lock);
+		m_wait_cond.wait(lock, [this, &b]() { return b.pending == 0 || m_queued > 0; });
+	}
+}
+
+void litehtml::thread_pool_executor::worker_proc(int index)
+{
+	t_pool	= this;
+	t_index	= index;
+
+	for (;;)
+	{
+		job jb;
+		if (take_job(index, jb))
+		{
+			execute(jb);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_wait_lock);
+		m_wait_cond.wait(lock, [this]() { return m_stop || m_queued > 0; });
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
+
+bool litehtml::thread_pool_executor::take_job(int index, job& jb)
+{
+	int count = (int) m_workers.size();
+	if (index >= 0)
+	{
+		// own jobs are taken from the back, so nested batches finish first
+		worker& w = *m_workers[index];
+		std::lock_guard<std::mutex> lock(w.lock);
+		if (!w.jobs.empty())
+		{
+			jb = w.jobs.back();
+			w.jobs.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+	int start = index >= 0 ? index + 1 : 0;
+	for (int i = 0; i < count; i++)
+	{
+		worker& w = *m_workers[(start + i) % count];
+		std::lock_guard<std::mutex> lock(w.lock);
+		if (!w.jobs.empty())
+		{
+			jb = w.jobs.front();
+			w.jobs.pop_front();
+			m_queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void litehtml::thread_pool_executor::execute(const job& jb)
+{
+	for (int i = jb.begin; i < jb.end; i++)
+	{
+		(*jb.owner->task)(i);
+	}
+	if (--jb.owner->pending == 0)
+	{
+		notify();
+	}
+}
+
+void litehtml::thread_pool_executor::notify()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wait_lock);
+	}
+	m_wait_cond.notify_all();
+}
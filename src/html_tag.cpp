@@ -5,6 +5,7 @@
 #include "stylesheet.h"
 #include "table.h"
 #include <algorithm>
+#include <chrono>
 #include <locale>
 #include "el_before_after.h"
 
@@ -12,6 +13,8 @@ litehtml::html_tag::html_tag(const std::shared_ptr<litehtml::document>& doc) : l
 {
 	m_box_sizing			= box_sizing_content_box;
 	m_z_index				= 0;
+	m_has_color				= false;
+	m_child_count			= 0;
 	m_overflow				= overflow_visible;
 	m_box					= 0;
 	m_text_align			= text_align_left;
@@ -31,6 +34,22 @@ litehtml::html_tag::html_tag(const std::shared_ptr<litehtml::document>& doc) : l
 	m_border_spacing_x		= 0;
 	m_border_spacing_y		= 0;
 	m_border_collapse		= border_collapse_separate;
+	m_table_layout			= table_layout_auto;
+	m_cells_static			= false;
+	m_hit_top				= 0;
+	m_hit_row_height		= 0;
+	m_defer_top				= -1;
+	m_layout_pending		= false;
+	m_pending_x				= 0;
+	m_pending_width			= 0;
+	m_layout_width			= -1;
+	m_layout_height			= 0;
+	m_inline_only			= false;
+	m_breaks_valid			= false;
+	m_breaks_min_width		= 0;
+	m_breaks_max_width		= 0;
+	m_breaks_ret_width		= 0;
+	m_measuring_text		= false;
 }
 
 litehtml::html_tag::~html_tag()
@@ -44,6 +63,12 @@ bool litehtml::html_tag::appendChild(const element::ptr &el)
 	{
 		el->parent(shared_from_this());
 		m_children.push_back(el);
+		m_breaks_valid = false;
+		m_child_index_valid = false;
+		// a child that is not parsed yet adds its content when parse_styles measures it
+		content_estimate delta;
+		el->estimate_content(delta);
+		add_child_estimate(delta);
 		return true;
 	}
 	return false;
@@ -55,6 +80,16 @@ bool litehtml::html_tag::removeChild(const element::ptr &el)
 	{
 		el->parent(nullptr);
 		m_children.erase(std::remove(m_children.begin(), m_children.end(), el), m_children.end());
+		m_breaks_valid = false;
+		m_child_index_valid = false;
+		content_estimate est;
+		el->estimate_content(est);
+		content_estimate delta;
+		delta.inline_width	= -est.inline_width;
+		delta.area			= -est.area;
+		delta.height		= -est.height;
+		delta.invalid		= -est.invalid;
+		add_child_estimate(delta);
 		return true;
 	}
 	return false;
@@ -68,6 +103,7 @@ void litehtml::html_tag::clearRecursive()
 		el->parent(nullptr);
 	}
 	m_children.clear();
+	m_child_index_valid = false;
 }
 
 
@@ -308,6 +344,12 @@ const litehtml::tchar_t* litehtml::html_tag::get_style_property( const tchar_t*
 
 void litehtml::html_tag::parse_styles(bool is_reparse)
 {
+	// the share of this element in the estimate of the parent, before the styles change
+	content_estimate old_est;
+	estimate_content(old_est);
+
+	m_breaks_valid = false;
+
 	const tchar_t* style = get_attr(_t("style"));
 
 	if(style)
@@ -318,10 +360,19 @@ void litehtml::html_tag::parse_styles(bool is_reparse)
 	init_font();
 	document::ptr doc = get_document();
 
+	// parsed once here, draw asks for the color of every text
+	const tchar_t* color = get_style_property(_t("color"), true, 0);
+	m_has_color = color != 0;
+	if(color)
+	{
+		m_color = web_color::from_string(color, doc->container());
+	}
+
 	m_el_position	= (element_position)	value_index(get_style_property(_t("position"),		false,	_t("static")),		element_position_strings,	element_position_fixed);
 	m_text_align	= (text_align)			value_index(get_style_property(_t("text-align"),		true,	_t("left")),		text_align_strings,			text_align_left);
 	m_overflow		= (overflow)			value_index(get_style_property(_t("overflow"),		false,	_t("visible")),		overflow_strings,			overflow_visible);
 	m_white_space	= (white_space)			value_index(get_style_property(_t("white-space"),	true,	_t("normal")),		white_space_strings,		white_space_normal);
+	style_display old_display = m_display;
 	m_display		= (style_display)		value_index(get_style_property(_t("display"),		false,	_t("inline")),		style_display_strings,		display_inline);
 	m_visibility	= (visibility)			value_index(get_style_property(_t("visibility"),	true,	_t("visible")),		visibility_strings,			visibility_visible);
 	m_box_sizing	= (box_sizing)			value_index(get_style_property(_t("box-sizing"),		false,	_t("content-box")),	box_sizing_strings,			box_sizing_content_box);
@@ -372,6 +423,15 @@ void litehtml::html_tag::parse_styles(bool is_reparse)
 			m_display = display_block;
 		}
 	}
+	if((old_display == display_inline_text) != (m_display == display_inline_text))
+	{
+		// the :nth-* selectors skip the text siblings
+		element::ptr el_parent = parent();
+		if(el_parent)
+		{
+			el_parent->m_child_index_valid = false;
+		}
+	}
 
 	m_css_text_indent.fromString(	get_style_property(_t("text-indent"),	true,	_t("0")),	_t("0"));
 
@@ -506,15 +566,58 @@ void litehtml::html_tag::parse_styles(bool is_reparse)
 
 	if(!is_reparse)
 	{
+		m_measuring_text = true;
 		for(auto& el : m_children)
 		{
 			el->parse_styles();
 		}
+		m_measuring_text = false;
+		measure_text_children();
+		calc_estimate();
+	}
+	propagate_estimate(old_est);
+}
+
+bool litehtml::html_tag::is_measuring_text() const
+{
+	return m_measuring_text;
+}
+
+void litehtml::html_tag::measure_text_children()
+{
+	// all text children share this element's font, so they are measured with one container call
+	std::vector<const tchar_t*> texts;
+	elements_vector els;
+	for(auto& el : m_children)
+	{
+		if(el->get_display() == display_inline_text && !el->is_break())
+		{
+			texts.push_back(el->get_draw_text());
+			els.push_back(el);
+		}
+	}
+	if(texts.empty())
+	{
+		return;
+	}
+	std::vector<int> widths(texts.size(), 0);
+	get_document()->container()->text_widths(&texts[0], (int) texts.size(), m_font, &widths[0]);
+	LITEHTML_STATS_ADD(text_width_calls, texts.size());
+	for(size_t i = 0; i < els.size(); i++)
+	{
+		els[i]->set_text_width(widths[i]);
 	}
 }
 
 int litehtml::html_tag::render( int x, int y, int max_width, bool second_pass )
 {
+#ifndef LITEHTML_NO_STATS
+	if(current_stats)
+	{
+		current_stats->element_renders++;
+		current_stats->renders_by_element[this]++;
+	}
+#endif
 	if (m_display == display_table || m_display == display_inline_table)
 	{
 		return render_table(x, y, max_width, second_pass);
@@ -533,6 +636,11 @@ int litehtml::html_tag::get_font_size() const
 	return m_font_size;
 }
 
+litehtml::web_color litehtml::html_tag::get_text_color(const web_color& def_color) const
+{
+	return m_has_color ? m_color : def_color;
+}
+
 int litehtml::html_tag::get_base_line()
 {
 	if(is_replaced())
@@ -593,6 +701,25 @@ void litehtml::html_tag::init()
 
 int litehtml::html_tag::select(const css_selector& selector, bool apply_pseudo)
 {
+#ifndef LITEHTML_NO_STATS
+	if(current_selector_profile)
+	{
+		selector_profile::entry* entry = current_selector_profile->begin_select(selector);
+		if(entry)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			int res = match_selector(selector, apply_pseudo);
+			current_selector_profile->end_select(entry, res != select_no_match, (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			return res;
+		}
+	}
+#endif
+	return match_selector(selector, apply_pseudo);
+}
+
+int litehtml::html_tag::match_selector(const css_selector& selector, bool apply_pseudo)
+{
+	LITEHTML_STATS_ADD(selectors_tested, 1);
 	int right_res = select(selector.m_right, apply_pseudo);
 	if(right_res == select_no_match)
 	{
@@ -674,6 +801,10 @@ int litehtml::html_tag::select(const css_selector& selector, bool apply_pseudo)
 			right_res = select_no_match;
 		}
 	}
+	if(right_res != select_no_match)
+	{
+		LITEHTML_STATS_ADD(selectors_matched, 1);
+	}
 	return right_res;
 }
 
@@ -1095,16 +1226,14 @@ int litehtml::html_tag::get_line_left( int y )
 			return m_cahe_line_left.val;
 		}
 
+		// add_float keeps the left floats sorted by their right edge, the first one on the line is the widest
 		int w = 0;
 		for(const auto& fb : m_floats_left)
 		{
 			if (y >= fb.pos.top() && y < fb.pos.bottom())
 			{
 				w = std::max(w, fb.pos.right());
-				if (w < fb.pos.right())
-				{
-					break;
-				}
+				break;
 			}
 		}
 		m_cahe_line_left.set_value(y, w);
@@ -1138,6 +1267,7 @@ int litehtml::html_tag::get_line_right( int y, int def_right )
 			}
 		}
 
+		// and the right floats by their left edge
 		int w = def_right;
 		m_cahe_line_right.is_default = true;
 		for(const auto& fb : m_floats_right)
@@ -1146,10 +1276,7 @@ int litehtml::html_tag::get_line_right( int y, int def_right )
 			{
 				w = std::min(w, fb.pos.left());
 				m_cahe_line_right.is_default = false;
-				if(w > fb.pos.left())
-				{
-					break;
-				}
+				break;
 			}
 		}
 		m_cahe_line_right.set_value(y, w);
@@ -1213,7 +1340,7 @@ int litehtml::html_tag::fix_line_width( int max_width, element_float flt )
 
 		if(!was_cleared)
 		{
-			m_boxes.pop_back();
+			recycle_last_box();
 
 			for(elements_vector::iterator i = els.begin(); i != els.end(); i++)
 			{
@@ -1357,22 +1484,17 @@ int litehtml::html_tag::find_next_line_top( int top, int width, int def_right )
 	{
 		int new_top = top;
 		int_vector points;
+		points.reserve((m_floats_left.size() + m_floats_right.size()) * 2);
 
 		for(const auto& fb : m_floats_left)
 		{
 			if(fb.pos.top() >= top)
 			{
-				if(find(points.begin(), points.end(), fb.pos.top()) == points.end())
-				{
-					points.push_back(fb.pos.top());
-				}
+				points.push_back(fb.pos.top());
 			}
 			if (fb.pos.bottom() >= top)
 			{
-				if (find(points.begin(), points.end(), fb.pos.bottom()) == points.end())
-				{
-					points.push_back(fb.pos.bottom());
-				}
+				points.push_back(fb.pos.bottom());
 			}
 		}
 
@@ -1380,23 +1502,18 @@ int litehtml::html_tag::find_next_line_top( int top, int width, int def_right )
 		{
 			if (fb.pos.top() >= top)
 			{
-				if (find(points.begin(), points.end(), fb.pos.top()) == points.end())
-				{
-					points.push_back(fb.pos.top());
-				}
+				points.push_back(fb.pos.top());
 			}
 			if (fb.pos.bottom() >= top)
 			{
-				if (find(points.begin(), points.end(), fb.pos.bottom()) == points.end())
-				{
-					points.push_back(fb.pos.bottom());
-				}
+				points.push_back(fb.pos.bottom());
 			}
 		}
 
 		if(!points.empty())
 		{
 			sort(points.begin(), points.end(), std::less<int>( ));
+			points.erase(unique(points.begin(), points.end()), points.end());
 			new_top = points.back();
 
 			for(auto pt : points)
@@ -1830,6 +1947,10 @@ bool litehtml::html_tag::find_styles_changes( position::vector& redraw_boxes, in
 			}
 		}
 	}
+	if(ret)
+	{
+		m_breaks_valid = false;
+	}
 	return ret;
 }
 
@@ -2059,7 +2180,9 @@ void litehtml::html_tag::draw_background( uint_ptr hdc, int x, int y, const posi
 	{
 		const background* bg = get_background();
 
-		position::vector boxes;
+		// reused between the calls, nothing below draws another background
+		static thread_local position::vector boxes;
+		boxes.clear();
 		get_inline_boxes(boxes);
 
 		background_paint bg_paint;
@@ -2183,6 +2306,11 @@ int litehtml::html_tag::place_element(const element::ptr &el, int max_width)
 		return el->render_inline(shared_from_this(), max_width);
 	}
 
+	if(el->get_display() != display_inline_text && !el->is_break())
+	{
+		m_inline_only = false;
+	}
+
 	element_position el_position = el->get_element_position();
 
 	if(el_position == element_position_absolute || el_position == element_position_fixed)
@@ -2511,7 +2639,7 @@ int litehtml::html_tag::finish_last_box(bool end_of_render)
 		if(m_boxes.back()->is_empty())
 		{
 			line_top = m_boxes.back()->top();
-			m_boxes.pop_back();
+			recycle_last_box();
 		}
 
 		if(!m_boxes.empty())
@@ -2522,6 +2650,29 @@ int litehtml::html_tag::finish_last_box(bool end_of_render)
 	return line_top;
 }
 
+void litehtml::html_tag::recycle_boxes()
+{
+	// the next layout usually needs as many boxes again, so they are kept instead of freed
+	while(!m_boxes.empty())
+	{
+		recycle_last_box();
+	}
+}
+
+void litehtml::html_tag::recycle_last_box()
+{
+	box::ptr& bx = m_boxes.back();
+	bx->clear_elements();
+	if(bx->get_type() == box_line)
+	{
+		m_spare_line_boxes.push_back(std::move(bx));
+	} else
+	{
+		m_spare_block_boxes.push_back(std::move(bx));
+	}
+	m_boxes.pop_back();
+}
+
 int litehtml::html_tag::new_box(const element::ptr &el, int max_width, line_context& line_ctx)
 {
 	line_ctx.top = get_cleared_top(el, finish_last_box());
@@ -2572,10 +2723,28 @@ int litehtml::html_tag::new_box(const element::ptr &el, int max_width, line_cont
 
 		font_metrics fm;
 		get_font(&fm);
-		m_boxes.emplace_back(std::unique_ptr<line_box>(new line_box(line_ctx.top, line_ctx.left + first_line_margin + text_indent, line_ctx.right, line_height(), fm, m_text_align)));
+		if(!m_spare_line_boxes.empty())
+		{
+			static_cast<line_box*>(m_spare_line_boxes.back().get())->reset(line_ctx.top, line_ctx.left + first_line_margin + text_indent, line_ctx.right, line_height(), fm, m_text_align);
+			m_boxes.push_back(std::move(m_spare_line_boxes.back()));
+			m_spare_line_boxes.pop_back();
+		} else
+		{
+			m_boxes.emplace_back(std::unique_ptr<line_box>(new line_box(line_ctx.top, line_ctx.left + first_line_margin + text_indent, line_ctx.right, line_height(), fm, m_text_align)));
+		}
+		LITEHTML_STATS_ADD(line_boxes, 1);
 	} else
 	{
-		m_boxes.emplace_back(std::unique_ptr<block_box>(new block_box(line_ctx.top, line_ctx.left, line_ctx.right)));
+		if(!m_spare_block_boxes.empty())
+		{
+			static_cast<block_box*>(m_spare_block_boxes.back().get())->reset(line_ctx.top, line_ctx.left, line_ctx.right);
+			m_boxes.push_back(std::move(m_spare_block_boxes.back()));
+			m_spare_block_boxes.pop_back();
+		} else
+		{
+			m_boxes.emplace_back(std::unique_ptr<block_box>(new block_box(line_ctx.top, line_ctx.left, line_ctx.right)));
+		}
+		LITEHTML_STATS_ADD(block_boxes, 1);
 	}
 
 	return line_ctx.top;
@@ -2759,6 +2928,11 @@ litehtml::css_length litehtml::html_tag::get_css_height() const
 	return m_css_height;
 }
 
+litehtml::box_sizing litehtml::html_tag::get_box_sizing() const
+{
+	return m_box_sizing;
+}
+
 size_t litehtml::html_tag::get_children_count() const
 {
 	return m_children.size();
@@ -2929,7 +3103,14 @@ litehtml::visibility litehtml::html_tag::get_visibility() const
 void litehtml::html_tag::draw_list_marker( uint_ptr hdc, const position &pos )
 {
 	list_marker lm;
+	get_list_marker(pos, lm);
+	lm.color = get_text_color(web_color(0, 0, 0));
+	lm.marker_type = m_list_style_type;
+	get_document()->container()->draw_list_marker(hdc, lm);
+}
 
+void litehtml::html_tag::get_list_marker( const position &pos, list_marker &lm )
+{
 	const tchar_t* list_image = get_style_property(_t("list-style-image"), true, 0);
 	size img_size;
 	if(list_image)
@@ -2968,14 +3149,14 @@ void litehtml::html_tag::draw_list_marker( uint_ptr hdc, const position &pos )
 	{
 		lm.pos.x -= sz_font;
 	}
-
-	lm.color = get_color(_t("color"), true, web_color(0, 0, 0));
-	lm.marker_type = m_list_style_type;
-	get_document()->container()->draw_list_marker(hdc, lm);
 }
 
 void litehtml::html_tag::draw_children( uint_ptr hdc, int x, int y, const position* clip, draw_flag flag, int zindex )
 {
+	if (m_layout_pending)
+	{
+		return;
+	}
 	if (m_display == display_table || m_display == display_inline_table)
 	{
 		draw_children_table(hdc, x, y, clip, flag, zindex);
@@ -2986,6 +3167,19 @@ void litehtml::html_tag::draw_children( uint_ptr hdc, int x, int y, const positi
 	}
 }
 
+static bool is_static_subtree(const litehtml::element::ptr& el)
+{
+	for(int i = 0; i < (int) el->get_children_count(); i++)
+	{
+		litehtml::element::ptr child = el->get_child(i);
+		if(child->get_element_position() != litehtml::element_position_static || !is_static_subtree(child))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 bool litehtml::html_tag::fetch_positioned()
 {
 	bool ret = false;
@@ -3010,9 +3204,38 @@ bool litehtml::html_tag::fetch_positioned()
 			ret = true;
 		}
 	}
+	if(m_grid)
+	{
+		// cells may be painted and hit-tested by rows only when nothing inside is positioned
+		m_cells_static = is_static_subtree(shared_from_this());
+	}
+
+	m_z_order.clear();
+	m_z_order.reserve(m_positioned.size());
+	for(int i = 0; i < (int) m_positioned.size(); i++)
+	{
+		m_z_order.push_back(std::make_pair(i, m_positioned[i]));
+	}
+	sort_z_order();
+
 	return ret;
 }
 
+void litehtml::html_tag::sort_z_order()
+{
+	// z-indexes can change with hover styles, so the order is checked on every paint
+	auto less = [](const std::pair<int, element::ptr>& left, const std::pair<int, element::ptr>& right)
+	{
+		int left_z	= left.second->get_zindex();
+		int right_z	= right.second->get_zindex();
+		return left_z < right_z || (left_z == right_z && left.first < right.first);
+	};
+	if(!std::is_sorted(m_z_order.begin(), m_z_order.end(), less))
+	{
+		std::sort(m_z_order.begin(), m_z_order.end(), less);
+	}
+}
+
 int litehtml::html_tag::get_zindex() const
 {
 	return m_z_index;
@@ -3020,16 +3243,17 @@ int litehtml::html_tag::get_zindex() const
 
 void litehtml::html_tag::render_positioned(render_type rt)
 {
+	document::ptr doc = get_document();
 	position wnd_position;
-	get_document()->container()->get_client_rect(wnd_position);
+	doc->container()->get_client_rect(wnd_position);
 
-	element_position el_position;
-	bool process;
-	for (auto& el : m_positioned)
+	// positioned subtrees are independent, so they can be rendered in parallel
+	doc->run_tasks((int) m_positioned.size(), [&](int i)
 	{
-		el_position = el->get_element_position();
+		const element::ptr& el = m_positioned[i];
+		element_position el_position = el->get_element_position();
 
-		process = false;
+		bool process = false;
 		if(el->get_display() != display_none)
 		{
 			if(el_position == element_position_absolute)
@@ -3206,45 +3430,58 @@ void litehtml::html_tag::render_positioned(render_type rt)
 				el->render(el->left(), el->top(), el->width(), true);
 				el->m_pos = pos;
 			}
+		}
+	});
 
-			if(el_position == element_position_fixed)
-			{
-				position fixed_pos;
-				el->get_redraw_box(fixed_pos);
-				get_document()->add_fixed_box(fixed_pos);
-			}
+	// nested positioned elements and fixed boxes are handled in the document order
+	for (auto& el : m_positioned)
+	{
+		if(rt != render_no_fixed && el->get_display() != display_none && el->get_element_position() == element_position_fixed)
+		{
+			// the box starts at the element, an empty position would stretch it to the origin
+			position fixed_pos = el->m_pos;
+			fixed_pos += el->m_padding;
+			fixed_pos += el->m_borders;
+			el->get_redraw_box(fixed_pos);
+			doc->add_fixed_box(fixed_pos);
 		}
 
 		el->render_positioned();
+		if(rt == render_fixed_only && el->get_element_position() == element_position_fixed)
+		{
+			// a full render updates the paint bounds of the whole document afterwards
+			el->calc_ink_overflow();
+		}
 	}
 
 	if(!m_positioned.empty())
 	{
-		std::stable_sort(m_positioned.begin(), m_positioned.end(), [](const litehtml::element::ptr& _Left, const litehtml::element::ptr& _Right)
+		auto by_zindex = [](const litehtml::element::ptr& _Left, const litehtml::element::ptr& _Right)
 		{
 			return (_Left->get_zindex() < _Right->get_zindex());
-		});
+		};
+		// stable_sort takes a temporary buffer, the list is usually still sorted from the last layout
+		if(!std::is_sorted(m_positioned.begin(), m_positioned.end(), by_zindex))
+		{
+			std::stable_sort(m_positioned.begin(), m_positioned.end(), by_zindex);
+		}
 	}
 }
 
 void litehtml::html_tag::draw_stacking_context( uint_ptr hdc, int x, int y, const position* clip, bool with_positioned )
 {
 	if(!is_visible()) return;
+	trace_span span("paint", "draw_stacking_context", this);
 
-	std::map<int, bool> zindexes;
+	// positioned descendants are drawn from the sorted list instead of a subtree walk per z-index
+	size_t positioned = 0;
+	with_positioned = with_positioned && !m_layout_pending;
 	if(with_positioned)
 	{
-		for(elements_vector::iterator i = m_positioned.begin(); i != m_positioned.end(); i++)
-		{
-			zindexes[(*i)->get_zindex()];
-		}
-
-		for(std::map<int, bool>::iterator idx = zindexes.begin(); idx != zindexes.end(); idx++)
+		sort_z_order();
+		for(; positioned < m_z_order.size() && m_z_order[positioned].second->get_zindex() < 0; positioned++)
 		{
-			if(idx->first < 0)
-			{
-				draw_children(hdc, x, y, clip, draw_positioned, idx->first);
-			}
+			draw_positioned_child(hdc, x, y, clip, m_z_order[positioned].second);
 		}
 	}
 	draw_children(hdc, x, y, clip, draw_block, 0);
@@ -3252,22 +3489,171 @@ void litehtml::html_tag::draw_stacking_context( uint_ptr hdc, int x, int y, cons
 	draw_children(hdc, x, y, clip, draw_inlines, 0);
 	if(with_positioned)
 	{
-		for(std::map<int, bool>::iterator idx = zindexes.begin(); idx != zindexes.end(); idx++)
+		for(; positioned < m_z_order.size(); positioned++)
 		{
-			if(idx->first == 0)
-			{
-				draw_children(hdc, x, y, clip, draw_positioned, idx->first);
-			}
+			draw_positioned_child(hdc, x, y, clip, m_z_order[positioned].second);
+		}
+	}
+}
+
+static bool is_table_part_box(litehtml::style_display display)
+{
+	// the cells of a table are painted through the grid, so tables, rows and row groups neither clip nor hide them
+	return	display == litehtml::display_table ||
+			display == litehtml::display_inline_table ||
+			display == litehtml::display_table_row ||
+			display == litehtml::display_table_row_group ||
+			display == litehtml::display_table_header_group ||
+			display == litehtml::display_table_footer_group;
+}
+
+// narrows clip to the content box that set_children_clip clips the children of el to;
+// returns false if nothing of clip is left
+static bool clip_to_children(const litehtml::element::ptr& el, int x, int y, litehtml::position& clip_box, const litehtml::position*& clip)
+{
+	if(el->get_overflow() == litehtml::overflow_visible || is_table_part_box(el->get_display()))
+	{
+		return true;
+	}
+	litehtml::position box = el->get_position();
+	box.x += x;
+	box.y += y;
+	if(clip)
+	{
+		int left	= std::max(box.left(), clip->left());
+		int top		= std::max(box.top(), clip->top());
+		int right	= std::min(box.right(), clip->right());
+		int bottom	= std::min(box.bottom(), clip->bottom());
+		if(left > right || top > bottom)
+		{
+			return false;
 		}
+		box = litehtml::position(left, top, right - left, bottom - top);
+	}
+	clip_box = box;
+	clip = &clip_box;
+	return true;
+}
 
-		for(std::map<int, bool>::iterator idx = zindexes.begin(); idx != zindexes.end(); idx++)
+void litehtml::html_tag::draw_positioned_child(uint_ptr hdc, int x, int y, const position* clip, const element::ptr& el)
+{
+	if(!el->is_visible())
+	{
+		return;
+	}
+
+	// the elements between this one and el, which the paint walk would go through; the list
+	// is emptied before el is drawn, so the nested calls can use it again
+	static thread_local elements_vector path;
+	path.clear();
+	int child_x = x + m_pos.x;
+	int child_y = y + m_pos.y;
+	element::ptr this_el = shared_from_this();
+	element::ptr el_parent = el->parent();
+	for(; el_parent && el_parent != this_el; el_parent = el_parent->parent())
+	{
+		if(el_parent->is_layout_pending() || (!el_parent->is_visible() && !is_table_part_box(el_parent->get_display())))
 		{
-			if(idx->first > 0)
-			{
-				draw_children(hdc, x, y, clip, draw_positioned, idx->first);
-			}
+			path.clear();
+			return;
+		}
+		child_x += el_parent->m_pos.x;
+		child_y += el_parent->m_pos.y;
+		path.push_back(el_parent);
+	}
+	if(!el_parent)
+	{
+		path.clear();
+		return;
+	}
+
+	bool fixed = el->get_element_position() == element_position_fixed;
+	if(fixed)
+	{
+		position browser_wnd;
+		get_document()->container()->get_client_rect(browser_wnd);
+		child_x = browser_wnd.x;
+		child_y = browser_wnd.y;
+	}
+
+	// el can only paint inside the overflow clips of the walk
+	position clip_box;
+	int clip_x = x;
+	int clip_y = y;
+	bool visible = clip_to_children(this_el, clip_x, clip_y, clip_box, clip);
+	clip_x += m_pos.x;
+	clip_y += m_pos.y;
+	for(auto i = path.rbegin(); visible && i != path.rend(); i++)
+	{
+		visible = clip_to_children(*i, clip_x, clip_y, clip_box, clip);
+		clip_x += (*i)->m_pos.x;
+		clip_y += (*i)->m_pos.y;
+	}
+	if(!visible || !el->is_ink_visible(child_x, child_y, clip))
+	{
+		path.clear();
+		return;
+	}
+
+	// the overflow clips of the walk, from this element down
+	int clips = 0;
+	clip_x = x;
+	clip_y = y;
+	if(!is_table_part_box(m_display) && set_children_clip(clip_x, clip_y))
+	{
+		clips++;
+	}
+	clip_x += m_pos.x;
+	clip_y += m_pos.y;
+	for(auto i = path.rbegin(); i != path.rend(); i++)
+	{
+		if(!is_table_part_box((*i)->get_display()) && (*i)->set_children_clip(clip_x, clip_y))
+		{
+			clips++;
 		}
+		clip_x += (*i)->m_pos.x;
+		clip_y += (*i)->m_pos.y;
 	}
+	path.clear();
+
+	if(el->get_display() == display_table_cell)
+	{
+		// the table paints its cells in flow, only the positioned content is left
+		el->draw_children(hdc, child_x, child_y, clip, draw_positioned, el->get_zindex());
+	} else
+	{
+		el->draw(hdc, child_x, child_y, clip);
+		el->draw_stacking_context(hdc, child_x, child_y, clip, true);
+	}
+
+	for(; clips > 0; clips--)
+	{
+		get_document()->container()->del_clip();
+	}
+}
+
+bool litehtml::html_tag::set_children_clip(int x, int y)
+{
+	if(m_overflow == overflow_visible)
+	{
+		return false;
+	}
+
+	position pos = m_pos;
+	pos.x += x;
+	pos.y += y;
+
+	position border_box = pos;
+	border_box += m_padding;
+	border_box += m_borders;
+
+	border_radiuses bdr_radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
+
+	bdr_radius -= m_borders;
+	bdr_radius -= m_padding;
+
+	get_document()->container()->set_clip(pos, bdr_radius, true, true);
+	return true;
 }
 
 litehtml::overflow litehtml::html_tag::get_overflow() const
@@ -3275,68 +3661,62 @@ litehtml::overflow litehtml::html_tag::get_overflow() const
 	return m_overflow;
 }
 
-bool litehtml::html_tag::is_nth_child(const element::ptr& el, int num, int off, bool of_type) const
+void litehtml::html_tag::update_child_index() const
 {
-	int idx = 1;
+	if(m_child_index_valid)
+	{
+		return;
+	}
+	// one pass numbers the children and a second one gives every child the count of its type
+	std::map<tstring, int> types;
+	int idx = 0;
 	for(const auto& child : m_children)
 	{
 		if(child->get_display() != display_inline_text)
 		{
-			if( (!of_type) || (of_type && !t_strcmp(el->get_tagName(), child->get_tagName())) )
-			{
-				if(el == child)
-				{
-					if(num != 0)
-					{
-						if((idx - off) >= 0 && (idx - off) % num == 0)
-						{
-							return true;
-						}
-
-					} else if(idx == off)
-					{
-						return true;
-					}
-					return false;
-				}
-				idx++;
-			}
-			if(el == child) break;
+			child->m_child_index	= ++idx;
+			child->m_type_index		= ++types[child->get_tagName()];
 		}
 	}
-	return false;
+	for(const auto& child : m_children)
+	{
+		if(child->get_display() != display_inline_text)
+		{
+			child->m_type_count = types[child->get_tagName()];
+		}
+	}
+	m_child_count		= idx;
+	m_child_index_valid	= true;
 }
 
-bool litehtml::html_tag::is_nth_last_child(const element::ptr& el, int num, int off, bool of_type) const
+static bool match_nth(int idx, int num, int off)
 {
-	int idx = 1;
-	for(elements_vector::const_reverse_iterator child = m_children.rbegin(); child != m_children.rend(); child++)
+	if(num != 0)
 	{
-		if((*child)->get_display() != display_inline_text)
-		{
-			if( !of_type || (of_type && !t_strcmp(el->get_tagName(), (*child)->get_tagName())) )
-			{
-				if(el == (*child))
-				{
-					if(num != 0)
-					{
-						if((idx - off) >= 0 && (idx - off) % num == 0)
-						{
-							return true;
-						}
+		return (idx - off) >= 0 && (idx - off) % num == 0;
+	}
+	return idx == off;
+}
 
-					} else if(idx == off)
-					{
-						return true;
-					}
-					return false;
-				}
-				idx++;
-			}
-			if(el == (*child)) break;
-		}
+bool litehtml::html_tag::is_nth_child(const element::ptr& el, int num, int off, bool of_type) const
+{
+	if(el->get_display() == display_inline_text)
+	{
+		return false;
 	}
-	return false;
+	update_child_index();
+	return match_nth(of_type ? el->m_type_index : el->m_child_index, num, off);
+}
+
+bool litehtml::html_tag::is_nth_last_child(const element::ptr& el, int num, int off, bool of_type) const
+{
+	if(el->get_display() == display_inline_text)
+	{
+		return false;
+	}
+	update_child_index();
+	int idx = of_type ? el->m_type_count - el->m_type_index + 1 : m_child_count - el->m_child_index + 1;
+	return match_nth(idx, num, off);
 }
 
 void litehtml::html_tag::parse_nth_child_params( tstring param, int &num, int &off )
@@ -3378,30 +3758,53 @@ void litehtml::html_tag::parse_nth_child_params( tstring param, int &num, int &o
 
 void litehtml::html_tag::calc_document_size( litehtml::size& sz, int x /*= 0*/, int y /*= 0*/ )
 {
+	// every child keeps its extent, so a later change can be carried up without the subtree
+	size children_size;
+	for(auto& el : m_children)
+	{
+		el->calc_document_size(children_size, m_pos.x, m_pos.y);
+	}
+	update_document_size();
+
 	if(is_visible() && m_el_position != element_position_fixed)
 	{
-		element::calc_document_size(sz, x, y);
+		sz.width	= std::max(sz.width,	x + m_doc_extent.width);
+		sz.height	= std::max(sz.height,	y + m_doc_extent.height);
+	}
+}
 
-		if(m_overflow == overflow_visible)
-		{
-			for(auto& el : m_children)
+void litehtml::html_tag::update_document_size()
+{
+	m_doc_extent.width	= right();
+	m_doc_extent.height	= bottom();
+	if(!have_parent())
+	{
+		// the root box is stretched below, only the height of its layout counts
+		m_doc_extent.height += m_layout_height - m_pos.height;
+	}
+
+	if(m_overflow == overflow_visible)
+	{
+		for(auto& el : m_children)
+		{
+			if(el->is_visible() && el->get_element_position() != element_position_fixed)
 			{
-				el->calc_document_size(sz, x + m_pos.x, y + m_pos.y);
+				m_doc_extent.width	= std::max(m_doc_extent.width,	m_pos.x + el->m_doc_extent.width);
+				m_doc_extent.height	= std::max(m_doc_extent.height,	m_pos.y + el->m_doc_extent.height);
 			}
 		}
+	}
 
-		// root element (<html>) must to cover entire window
-		if(!have_parent())
-		{
-			position client_pos;
-			get_document()->container()->get_client_rect(client_pos);
-			m_pos.height = std::max(sz.height, client_pos.height) - content_margins_top() - content_margins_bottom();
-			m_pos.width	 = std::max(sz.width, client_pos.width) - content_margins_left() - content_margins_right();
-		}
+	// root element (<html>) must to cover entire window
+	if(!have_parent())
+	{
+		position client_pos;
+		get_document()->container()->get_client_rect(client_pos);
+		m_pos.height = std::max(m_doc_extent.height, client_pos.height) - content_margins_top() - content_margins_bottom();
+		m_pos.width	 = std::max(m_doc_extent.width, client_pos.width) - content_margins_left() - content_margins_right();
 	}
 }
 
-
 void litehtml::html_tag::get_redraw_box(litehtml::position& pos, int x /*= 0*/, int y /*= 0*/)
 {
 	if(is_visible())
@@ -3421,6 +3824,153 @@ void litehtml::html_tag::get_redraw_box(litehtml::position& pos, int x /*= 0*/,
 	}
 }
 
+static void add_ink_box(litehtml::position& ink, const litehtml::position& box)
+{
+	if(box.empty())
+	{
+		return;
+	}
+	if(ink.empty())
+	{
+		ink = box;
+		return;
+	}
+	int left	= std::min(ink.left(),		box.left());
+	int top		= std::min(ink.top(),		box.top());
+	int right	= std::max(ink.right(),		box.right());
+	int bottom	= std::max(ink.bottom(),	box.bottom());
+	ink.x		= left;
+	ink.y		= top;
+	ink.width	= right - left;
+	ink.height	= bottom - top;
+}
+
+void litehtml::html_tag::calc_ink_overflow()
+{
+	for(auto& el : m_children)
+	{
+		el->calc_ink_overflow();
+	}
+	update_ink_overflow();
+}
+
+void litehtml::html_tag::update_overflow()
+{
+	// the children are up to date, only this element is recomputed
+	update_document_size();
+	update_ink_overflow();
+}
+
+void litehtml::html_tag::update_ink_overflow()
+{
+	element::calc_ink_overflow();
+
+	if(m_display == display_inline)
+	{
+		static thread_local position::vector boxes;
+		boxes.clear();
+		get_inline_boxes(boxes);
+		for(const auto& box : boxes)
+		{
+			add_ink_box(m_ink_overflow, box);
+		}
+	}
+	if(m_display == display_list_item && m_list_style_type != list_style_type_none)
+	{
+		// outside markers are painted left of the border box
+		list_marker lm;
+		get_list_marker(m_pos, lm);
+		add_ink_box(m_ink_overflow, lm.pos);
+	}
+
+	for(auto& el : m_children)
+	{
+		// hidden elements are kept, since hover styles can show them without a new layout
+		if(el->skip() || el->get_display() == display_none)
+		{
+			continue;
+		}
+		if(!el->m_ink_bounded)
+		{
+			m_ink_bounded = false;
+		} else if(m_overflow == overflow_visible)
+		{
+			// children are painted relative to the content box
+			position box = el->m_ink_overflow;
+			box.x	+= m_pos.x;
+			box.y	+= m_pos.y;
+			add_ink_box(m_ink_overflow, box);
+		}
+	}
+
+	build_hit_index();
+}
+
+void litehtml::html_tag::build_hit_index()
+{
+	// the rows are emptied in place, so the next layout with the same children reuses their buffers
+	for(auto& row : m_hit_rows)
+	{
+		row.clear();
+	}
+	m_hit_always.clear();
+
+	// a few children are cheaper to test one by one
+	const int min_children = 32;
+	if((int) m_children.size() < min_children || !get_document()->use_hit_index())
+	{
+		m_hit_rows.clear();
+		return;
+	}
+
+	int top		= INT_MAX;
+	int bottom	= INT_MIN;
+	for(const auto& el : m_children)
+	{
+		if(!el->skip() && el->get_display() != display_none && el->m_ink_bounded)
+		{
+			top		= std::min(top, el->m_ink_overflow.top());
+			bottom	= std::max(bottom, el->m_ink_overflow.bottom());
+		}
+	}
+	if(top > bottom)
+	{
+		m_hit_rows.clear();
+		return;
+	}
+
+	int rows_count		= (int) m_children.size() / 4;
+	m_hit_top			= top;
+	m_hit_row_height	= std::max(1, (bottom - top) / rows_count + 1);
+	m_hit_rows.resize(rows_count);
+
+	// the indices stay in the document order, so the rows can be walked like the children
+	for(int i = 0; i < (int) m_children.size(); i++)
+	{
+		const element::ptr& el = m_children[i];
+		if(el->skip() || el->get_display() == display_none)
+		{
+			continue;
+		}
+		if(!el->m_ink_bounded)
+		{
+			m_hit_always.push_back(i);
+			continue;
+		}
+		int first	= (el->m_ink_overflow.top() - m_hit_top) / m_hit_row_height;
+		int last	= (el->m_ink_overflow.bottom() - m_hit_top) / m_hit_row_height;
+		if(last - first > rows_count / 2)
+		{
+			m_hit_always.push_back(i);
+			continue;
+		}
+		for(int row = first; row <= last && row < rows_count; row++)
+		{
+			m_hit_rows[row].push_back(i);
+		}
+	}
+}
+
 litehtml::element::ptr litehtml::html_tag::find_adjacent_sibling( const element::ptr& el, const css_selector& selector, bool apply_pseudo /*= true*/, bool* is_pseudo /*= 0*/ )
 {
 	element::ptr ret;
@@ -3559,6 +4109,7 @@ void litehtml::html_tag::remove_before_after()
 		if( !t_strcmp(m_children.front()->get_tagName(), _t("::before")) )
 		{
 			m_children.erase(m_children.begin());
+			m_child_index_valid = false;
 		}
 	}
 	if(!m_children.empty())
@@ -3566,6 +4117,7 @@ void litehtml::html_tag::remove_before_after()
 		if( !t_strcmp(m_children.back()->get_tagName(), _t("::after")) )
 		{
 			m_children.erase(m_children.end() - 1);
+			m_child_index_valid = false;
 		}
 	}
 }
@@ -3582,6 +4134,7 @@ litehtml::element::ptr litehtml::html_tag::get_element_before()
 	element::ptr el = std::make_shared<el_before>(get_document());
 	el->parent(shared_from_this());
 	m_children.insert(m_children.begin(), el);
+	m_child_index_valid = false;
 	return el;
 }
 
@@ -3696,6 +4249,11 @@ litehtml::element::ptr litehtml::html_tag::get_child_by_point(int x, int y, int
 {
 	element::ptr ret = 0;
 
+	if(m_layout_pending)
+	{
+		return ret;
+	}
+
 	if(m_overflow > overflow_visible)
 	{
 		if(!m_pos.is_point_inside(x, y))
@@ -3708,94 +4266,136 @@ litehtml::element::ptr litehtml::html_tag::get_child_by_point(int x, int y, int
 	pos.x	= x - pos.x;
 	pos.y	= y - pos.y;
 
+	if(m_grid && m_cells_static)
+	{
+		return get_cell_by_point(pos.x, pos.y, client_x, client_y, flag, zindex);
+	}
+
+	if(!m_hit_rows.empty())
+	{
+		// merge the children in the row of the point with the unbounded ones, last child first
+		static const std::vector<int> empty_row;
+		int row = pos.y - m_hit_top >= 0 ? (pos.y - m_hit_top) / m_hit_row_height : -1;
+		const std::vector<int>& candidates = (row >= 0 && row < (int) m_hit_rows.size()) ? m_hit_rows[row] : empty_row;
+		std::vector<int>::const_reverse_iterator i = candidates.rbegin();
+		std::vector<int>::const_reverse_iterator j = m_hit_always.rbegin();
+		while(!ret && (i != candidates.rend() || j != m_hit_always.rend()))
+		{
+			int idx;
+			if(j == m_hit_always.rend() || (i != candidates.rend() && *i > *j))
+			{
+				idx = *i++;
+			} else
+			{
+				idx = *j++;
+			}
+			ret = get_child_item_by_point(m_children[idx], pos.x, pos.y, client_x, client_y, flag, zindex);
+		}
+		return ret;
+	}
+
 	for(elements_vector::reverse_iterator i = m_children.rbegin(); i != m_children.rend() && !ret; i++)
 	{
-		element::ptr el = (*i);
+		ret = get_child_item_by_point(*i, pos.x, pos.y, client_x, client_y, flag, zindex);
+	}
+
+	return ret;
+}
+
+litehtml::element::ptr litehtml::html_tag::get_child_item_by_point(const element::ptr& item, int x, int y, int client_x, int client_y, draw_flag flag, int zindex)
+{
+	element::ptr ret = 0;
+	element::ptr el = item;
+
+	// fixed elements are tested with the client coordinates, and their ink overflow is unbounded
+	if(!el->is_ink_point_inside(x, y))
+	{
+		return ret;
+	}
 
-		if(el->is_visible() && el->get_display() != display_inline_text)
+	if(el->is_visible() && el->get_display() != display_inline_text)
+	{
+		switch(flag)
 		{
-			switch(flag)
+		case draw_positioned:
+			if(el->is_positioned() && el->get_zindex() == zindex)
 			{
-			case draw_positioned:
-				if(el->is_positioned() && el->get_zindex() == zindex)
+				if(el->get_element_position() == element_position_fixed)
 				{
-					if(el->get_element_position() == element_position_fixed)
-					{
-						ret = el->get_element_by_point(client_x, client_y, client_x, client_y);
-						if(!ret && (*i)->is_point_inside(client_x, client_y))
-						{
-							ret = (*i);
-						}
-					} else
+					ret = el->get_element_by_point(client_x, client_y, client_x, client_y);
+					if(!ret && item->is_point_inside(client_x, client_y))
 					{
-						ret = el->get_element_by_point(pos.x, pos.y, client_x, client_y);
-						if(!ret && (*i)->is_point_inside(pos.x, pos.y))
-						{
-							ret = (*i);
-						}
+						ret = item;
 					}
-					el = 0;
-				}
-				break;
-			case draw_block:
-				if(!el->is_inline_box() && el->get_float() == float_none && !el->is_positioned())
+				} else
 				{
-					if(el->is_point_inside(pos.x, pos.y))
+					ret = el->get_element_by_point(x, y, client_x, client_y);
+					if(!ret && item->is_point_inside(x, y))
 					{
-						ret = el;
+						ret = item;
 					}
 				}
-				break;
-			case draw_floats:
-				if(el->get_float() != float_none && !el->is_positioned())
+				el = 0;
+			}
+			break;
+		case draw_block:
+			if(!el->is_inline_box() && el->get_float() == float_none && !el->is_positioned())
+			{
+				if(el->is_point_inside(x, y))
 				{
-					ret = el->get_element_by_point(pos.x, pos.y, client_x, client_y);
+					ret = el;
+				}
+			}
+			break;
+		case draw_floats:
+			if(el->get_float() != float_none && !el->is_positioned())
+			{
+				ret = el->get_element_by_point(x, y, client_x, client_y);
 
-					if(!ret && (*i)->is_point_inside(pos.x, pos.y))
-					{
-						ret = (*i);
-					}
+				if(!ret && item->is_point_inside(x, y))
+				{
+					ret = item;
+				}
+				el = 0;
+			}
+			break;
+		case draw_inlines:
+			if(el->is_inline_box() && el->get_float() == float_none && !el->is_positioned())
+			{
+				if(el->get_display() == display_inline_block)
+				{
+					ret = el->get_element_by_point(x, y, client_x, client_y);
 					el = 0;
 				}
-				break;
-			case draw_inlines:
-				if(el->is_inline_box() && el->get_float() == float_none && !el->is_positioned())
+				if(!ret && item->is_point_inside(x, y))
 				{
-					if(el->get_display() == display_inline_block)
-					{
-						ret = el->get_element_by_point(pos.x, pos.y, client_x, client_y);
-						el = 0;
-					}
-					if(!ret && (*i)->is_point_inside(pos.x, pos.y))
-					{
-						ret = (*i);
-					}
+					ret = item;
 				}
-				break;
-			default:
-				break;
 			}
+			break;
+		default:
+			break;
+		}
 
-			if(el && !el->is_positioned())
+		if(el && !el->is_positioned())
+		{
+			if(flag == draw_positioned)
+			{
+				element::ptr child = el->get_child_by_point(x, y, client_x, client_y, flag, zindex);
+				if(child)
+				{
+					ret = child;
+				}
+			} else
 			{
-				if(flag == draw_positioned)
+				if(	el->get_float() == float_none &&
+					el->get_display() != display_inline_block)
 				{
-					element::ptr child = el->get_child_by_point(pos.x, pos.y, client_x, client_y, flag, zindex);
+					element::ptr child = el->get_child_by_point(x, y, client_x, client_y, flag, zindex);
 					if(child)
 					{
 						ret = child;
 					}
-				} else
-				{
-					if(	el->get_float() == float_none &&
-						el->get_display() != display_inline_block)
-					{
-						element::ptr child = el->get_child_by_point(pos.x, pos.y, client_x, client_y, flag, zindex);
-						if(child)
-						{
-							ret = child;
-						}
-					}
 				}
 			}
 		}
@@ -3804,6 +4404,46 @@ litehtml::element::ptr litehtml::html_tag::get_child_by_point(int x, int y, int
 	return ret;
 }
 
+litehtml::element::ptr litehtml::html_tag::get_cell_by_point(int x, int y, int client_x, int client_y, draw_flag flag, int zindex)
+{
+	element::ptr ret = 0;
+
+	int first_row = 0;
+	int last_row = 0;
+	if(!m_grid->find_rows(y, y, first_row, last_row))
+	{
+		return ret;
+	}
+
+	// rows and row groups have no size, so the cells are tested like children of the table
+	element::ptr this_el = shared_from_this();
+	for(int row = last_row; row >= first_row && !ret; row--)
+	{
+		for(int col = m_grid->cols_count() - 1; col >= 0 && !ret; col--)
+		{
+			table_cell* cell = m_grid->cell(col, row);
+			if(!cell->el)
+			{
+				continue;
+			}
+			bool visible = true;
+			for(element::ptr el_parent = cell->el->parent(); el_parent && el_parent != this_el; el_parent = el_parent->parent())
+			{
+				if(!el_parent->is_visible() || el_parent->get_overflow() > overflow_visible)
+				{
+					visible = false;
+					break;
+				}
+			}
+			if(visible)
+			{
+				ret = get_child_item_by_point(cell->el, x, y, client_x, client_y, flag, zindex);
+			}
+		}
+	}
+	return ret;
+}
+
 litehtml::element::ptr litehtml::html_tag::get_element_by_point(int x, int y, int client_x, int client_y)
 {
 	if(!is_visible()) return 0;
@@ -3918,6 +4558,12 @@ const litehtml::background* litehtml::html_tag::get_background(bool own_only)
 
 int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass /*= false*/)
 {
+	trace_span span("layout", "render_box", this);
+	if (!second_pass && defer_render(x, y, max_width))
+	{
+		return max_width;
+	}
+
 	int parent_width = max_width;
 
 	calc_outlines(parent_width);
@@ -3928,6 +4574,9 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 	m_pos.x += content_margins_left();
 	m_pos.y += content_margins_top();
 
+	m_layout_pending = false;
+	init_defer_top();
+
 	int ret_width = 0;
 
 	def_value<int>	block_width(0);
@@ -3966,7 +4615,6 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 
 	m_floats_left.clear();
 	m_floats_right.clear();
-	m_boxes.clear();
 	m_cahe_line_left.invalidate();
 	m_cahe_line_right.invalidate();
 
@@ -3992,46 +4640,59 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 
 	bool was_space = false;
 
-	for (auto el : m_children)
+	if (reuse_line_breaks(max_width))
 	{
-		// we don't need process absolute and fixed positioned element on the second pass
-		if (second_pass)
-		{
-			el_position = el->get_element_position();
-			if ((el_position == element_position_absolute || el_position == element_position_fixed)) continue;
-		}
+		ret_width = std::max(ret_width, m_breaks_ret_width);
+	}
+	else
+	{
+		recycle_boxes();
+		m_inline_only = true;
+		int lines_width = 0;
 
-		// skip spaces to make rendering a bit faster
-		if (skip_spaces)
+		for (auto el : m_children)
 		{
-			if (el->is_white_space())
+			// we don't need process absolute and fixed positioned element on the second pass
+			if (second_pass)
 			{
-				if (was_space)
+				el_position = el->get_element_position();
+				if ((el_position == element_position_absolute || el_position == element_position_fixed)) continue;
+			}
+
+			// skip spaces to make rendering a bit faster
+			if (skip_spaces)
+			{
+				if (el->is_white_space())
 				{
-					el->skip(true);
-					continue;
+					if (was_space)
+					{
+						el->skip(true);
+						continue;
+					}
+					else
+					{
+						was_space = true;
+					}
 				}
 				else
 				{
-					was_space = true;
+					was_space = false;
 				}
 			}
-			else
+
+			// place element into rendering flow
+			int rw = place_element(el, max_width);
+			if (rw > lines_width)
 			{
-				was_space = false;
+				lines_width = rw;
 			}
 		}
 
-		// place element into rendering flow
-		int rw = place_element(el, max_width);
-		if (rw > ret_width)
-		{
-			ret_width = rw;
-		}
+		finish_last_box(true);
+		save_line_breaks(max_width, lines_width);
+		ret_width = std::max(ret_width, lines_width);
 	}
 
-	finish_last_box(true);
-
 	if (block_width.is_default() && is_inline_box())
 	{
 		m_pos.width = ret_width;
@@ -4117,7 +4778,10 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 
 			size sz;
 			const tchar_t* list_image_baseurl = get_style_property(_t("list-style-image-baseurl"), true, 0);
-			get_document()->container()->get_image_size(url.c_str(), list_image_baseurl, sz);
+			{
+				auto lock = get_document()->lock_container();
+				get_document()->container()->get_image_size(url.c_str(), list_image_baseurl, sz);
+			}
 			if (min_height < sz.height)
 			{
 				min_height = sz.height;
@@ -4178,85 +4842,535 @@ int litehtml::html_tag::render_box(int x, int y, int max_width, bool second_pass
 		}
 	}
 
+	if (!second_pass)
+	{
+		m_layout_width		= parent_width;
+		m_layout_height		= m_pos.height;
+		m_layout_margins	= m_margins;
+	}
 
 	return ret_width;
 }
 
-int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pass /*= false*/)
+bool litehtml::html_tag::reuse_line_breaks(int max_width)
 {
-	if (!m_grid) return 0;
-
-	int parent_width = max_width;
-
-	calc_outlines(parent_width);
-
-	m_pos.clear();
-	m_pos.move_to(x, y);
-
-	m_pos.x += content_margins_left();
-	m_pos.y += content_margins_top();
-
-	def_value<int>	block_width(0);
-
-	if (!m_css_width.is_predefined())
+	if (!m_breaks_valid || max_width < m_breaks_min_width || max_width > m_breaks_max_width)
 	{
-		max_width = block_width = calc_width(parent_width) - m_padding.width() - m_borders.width();
+		return false;
 	}
-	else
+	for (const auto& box : m_boxes)
 	{
-		if (max_width)
+		int line_left = 0;
+		int line_right = max_width;
+		get_line_left_right(box->top(), max_width, line_left, line_right);
+		if (line_left != 0 || line_right != max_width)
 		{
-			max_width -= content_margins_left() + content_margins_right();
+			return false;
 		}
 	}
+	for (const auto& box : m_boxes)
+	{
+		box->set_right(max_width);
+	}
+	return true;
+}
 
-	// Calculate table spacing
-	int table_width_spacing = 0;
-	if (m_border_collapse == border_collapse_separate)
+void litehtml::html_tag::save_line_breaks(int max_width, int lines_width)
+{
+	m_breaks_valid = false;
+
+	// only paragraphs of plain inline content without floats can be reused
+	if (!m_inline_only || m_boxes.empty() ||
+		(m_css_text_indent.units() == css_units_percentage && m_css_text_indent.val() != 0))
 	{
-		table_width_spacing = m_border_spacing_x * (m_grid->cols_count() + 1);
+		return;
 	}
-	else
+	int min_width = 0;
+	int max_right = INT_MAX;
+	static thread_local elements_vector els;
+	for (const auto& box : m_boxes)
 	{
-		table_width_spacing = 0;
-
-		if (m_grid->cols_count())
+		if (box->get_type() != box_line)
 		{
-			table_width_spacing -= std::min(border_left(), m_grid->column(0).border_left);
-			table_width_spacing -= std::min(border_right(), m_grid->column(m_grid->cols_count() - 1).border_right);
+			return;
 		}
-
-		for (int col = 1; col < m_grid->cols_count(); col++)
+		int line_left = 0;
+		int line_right = max_width;
+		get_line_left_right(box->top(), max_width, line_left, line_right);
+		if (line_left != 0 || line_right != max_width)
 		{
-			table_width_spacing -= std::min(m_grid->column(col).border_left, m_grid->column(col - 1).border_right);
+			return;
 		}
+		els.clear();
+		box->get_elements(els);
+		for (const auto& el : els)
+		{
+			if (el->get_element_position() == element_position_relative)
+			{
+				els.clear();
+				return;
+			}
+		}
+		int box_min = 0;
+		int box_max = 0;
+		box->get_right_range(box_min, box_max);
+		min_width = std::max(min_width, box_min);
+		max_right = std::min(max_right, box_max);
+	}
+	els.clear();
+	m_breaks_valid		= true;
+	m_breaks_min_width	= min_width;
+	m_breaks_max_width	= max_right;
+	m_breaks_ret_width	= lines_width;
+}
+
+void litehtml::html_tag::init_defer_top()
+{
+	m_defer_top = -1;
+
+	element::ptr el_parent = parent();
+	if (!el_parent || !get_document()->is_layout_deferred())
+	{
+		return;
 	}
+	// only the body and plain blocks in its normal flow can leave children unrendered
+	if (is_body())
+	{
+		m_defer_top = el_parent->get_placement().y + m_pos.y;
+	}
+	else if (el_parent->get_defer_top() >= 0 &&
+		m_display == display_block &&
+		m_el_position == element_position_static &&
+		m_float == float_none &&
+		!is_floats_holder() &&
+		m_css_height.is_predefined() &&
+		m_css_min_height.val() == 0)
+	{
+		m_defer_top = el_parent->get_defer_top() + m_pos.y;
+	}
+}
 
+bool litehtml::html_tag::defer_render(int x, int y, int max_width)
+{
+	element::ptr el_parent = parent();
+	if (!el_parent || el_parent->get_defer_top() < 0)
+	{
+		return false;
+	}
+	if (m_display != display_block ||
+		m_el_position != element_position_static ||
+		m_float != float_none ||
+		m_clear != clear_none)
+	{
+		return false;
+	}
+	document::ptr doc = get_document();
+	if (!doc->can_defer_layout(el_parent->get_defer_top() + y) || el_parent->get_floats_height() > y)
+	{
+		return false;
+	}
 
-	// Calculate the minimum content width (MCW) of each cell: the formatted content may span any number of lines but may not overflow the cell box. 
-	// If the specified 'width' (W) of the cell is greater than MCW, W is the minimum cell width. A value of 'auto' means that MCW is the minimum 
-	// cell width.
-	// 
-	// Also, calculate the "maximum" cell width of each cell: formatting the content without breaking lines other than where explicit line breaks occur.
+	calc_outlines(max_width);
 
-	if (m_grid->cols_count() == 1 && !block_width.is_default())
+	int width = max_width - content_margins_left() - content_margins_right();
+	if (!m_css_width.is_predefined())
 	{
-		for (int row = 0; row < m_grid->rows_count(); row++)
+		width = calc_width(max_width);
+		if (m_box_sizing == box_sizing_border_box)
 		{
-			table_cell* cell = m_grid->cell(0, row);
-			if (cell && cell->el)
+			width -= m_padding.width() + m_borders.width();
+		}
+	}
+
+	int height = 0;
+	if (m_layout_width == max_width)
+	{
+		// the size of the previous full layout is the best guess
+		height				= m_layout_height;
+		m_margins.top		= m_layout_margins.top;
+		m_margins.bottom	= m_layout_margins.bottom;
+	}
+	else if (!estimate_height(width, height))
+	{
+		return false;
+	}
+
+	recycle_boxes();
+	m_floats_left.clear();
+	m_floats_right.clear();
+	m_cahe_line_left.invalidate();
+	m_cahe_line_right.invalidate();
+
+	m_pos.width		= width;
+	m_pos.height	= height;
+	calc_auto_margins(max_width);
+	m_pos.x			= x + content_margins_left();
+	m_pos.y			= y + content_margins_top();
+
+	m_defer_top			= -1;
+	m_layout_pending	= true;
+	m_pending_x			= x;
+	m_pending_width		= max_width;
+	doc->add_pending_layout(shared_from_this());
+
+	return true;
+}
+
+bool litehtml::html_tag::estimate_height(int width, int& height)
+{
+	if (m_estimate.invalid)
+	{
+		return false;
+	}
+	content_estimate est;
+	estimate_block(est);
+	height = est.height;
+	if (width > 0)
+	{
+		height += (int) (est.area / width);
+	}
+	int predefined_height = 0;
+	if (get_predefined_height(predefined_height))
+	{
+		height = predefined_height;
+	}
+	return true;
+}
+
+void litehtml::html_tag::estimate_block(content_estimate& est) const
+{
+	// the inline content left after the last child block ends with a line of its own
+	est.area	+= m_estimate.area + (long long) m_estimate.inline_width * line_height();
+	est.height	+= m_estimate.height;
+	if (m_estimate.inline_width)
+	{
+		est.height += line_height();
+	}
+}
+
+void litehtml::html_tag::calc_estimate()
+{
+	m_estimate = content_estimate();
+	for (auto& el : m_children)
+	{
+		el->estimate_content(m_estimate);
+	}
+}
+
+void litehtml::html_tag::update_estimate()
+{
+	content_estimate old_est;
+	estimate_content(old_est);
+	calc_estimate();
+	propagate_estimate(old_est);
+}
+
+void litehtml::html_tag::add_child_estimate(const content_estimate& delta)
+{
+	content_estimate old_est;
+	estimate_content(old_est);
+	m_estimate.inline_width	+= delta.inline_width;
+	m_estimate.area			+= delta.area;
+	m_estimate.height		+= delta.height;
+	m_estimate.invalid		+= delta.invalid;
+	propagate_estimate(old_est);
+}
+
+void litehtml::html_tag::propagate_estimate(const content_estimate& old_est)
+{
+	// a parent parsing its children sums them up itself afterwards
+	element::ptr el_parent = parent();
+	if (!el_parent || el_parent->is_measuring_text())
+	{
+		return;
+	}
+	content_estimate est;
+	estimate_content(est);
+	if (est.inline_width != old_est.inline_width || est.area != old_est.area || est.height != old_est.height || est.invalid != old_est.invalid)
+	{
+		content_estimate delta;
+		delta.inline_width	= est.inline_width - old_est.inline_width;
+		delta.area			= est.area - old_est.area;
+		delta.height		= est.height - old_est.height;
+		delta.invalid		= est.invalid - old_est.invalid;
+		el_parent->add_child_estimate(delta);
+	}
+}
+
+void litehtml::html_tag::estimate_content(content_estimate& est)
+{
+	// positioned subtrees are rendered by render_positioned, so they cannot wait
+	if (m_el_position == element_position_absolute || m_el_position == element_position_fixed)
+	{
+		est.invalid++;
+		return;
+	}
+	if (m_display == display_none)
+	{
+		return;
+	}
+	if (m_estimate.invalid)
+	{
+		est.invalid++;
+		return;
+	}
+	if (m_display == display_inline)
+	{
+		est.inline_width	+= m_estimate.inline_width;
+		est.area			+= m_estimate.area;
+		est.height			+= m_estimate.height;
+		return;
+	}
+	if (!m_css_height.is_predefined() && m_css_height.units() != css_units_percentage)
+	{
+		est.height += m_css_height.calc_percent(0);
+	} else
+	{
+		estimate_block(est);
+	}
+	est.height += m_margins.height() + m_padding.height() + m_borders.height();
+}
+
+int litehtml::html_tag::get_defer_top() const
+{
+	return m_defer_top;
+}
+
+bool litehtml::html_tag::is_layout_pending() const
+{
+	return m_layout_pending;
+}
+
+int litehtml::html_tag::realize_layout()
+{
+	if (!m_layout_pending)
+	{
+		return 0;
+	}
+
+	int old_bottom = bottom();
+	int old_margin = m_box ? m_box->bottom_margin() : 0;
+	render(m_pending_x, m_pos.y - content_margins_top(), m_pending_width);
+
+	int dy = bottom() - old_bottom;
+	element::ptr el_parent = parent();
+	if (el_parent)
+	{
+		el_parent->update_child_height(shared_from_this(), dy, old_margin);
+	}
+	return dy;
+}
+
+static int collapsed_margin_shift(int prev_margin, int margin_top)
+{
+	// the same rule place_element uses for adjacent block boxes
+	int shift = prev_margin > margin_top ? margin_top : prev_margin;
+	return shift >= 0 ? shift : 0;
+}
+
+void litehtml::html_tag::update_child_height(const element::ptr& el, int dy, int old_margin)
+{
+	int new_margin = el->m_box ? el->m_box->bottom_margin() : 0;
+	if (!dy && new_margin == old_margin)
+	{
+		return;
+	}
+	int old_bottom = el->bottom() - dy;
+
+	// the following block may collapse with the new bottom margin
+	int shift = dy;
+	size_t el_box = m_boxes.size();
+	for (size_t i = 0; i < m_boxes.size(); i++)
+	{
+		if (m_boxes[i].get() == el->m_box)
+		{
+			el_box = i;
+			break;
+		}
+	}
+	if (el_box + 1 < m_boxes.size() && m_boxes[el_box + 1]->get_type() == box_block)
+	{
+		elements_vector els;
+		m_boxes[el_box + 1]->get_elements(els);
+		if (!els.empty() && !els.front()->is_inline_box())
+		{
+			shift += collapsed_margin_shift(old_margin, els.front()->margin_top()) - collapsed_margin_shift(new_margin, els.front()->margin_top());
+		}
+	}
+
+	// move everything placed after the changed child
+	for (size_t i = el_box + 1; i < m_boxes.size(); i++)
+	{
+		m_boxes[i]->y_shift(shift);
+	}
+	bool found = false;
+	for (auto& child : m_children)
+	{
+		if (found)
+		{
+			if (child->get_display() != display_none)
 			{
-				cell->min_width = cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
-				cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+				// floats and statically positioned elements are not in the boxes
+				element_position el_pos = child->get_element_position();
+				if (child->get_float() != float_none ||
+					((el_pos == element_position_absolute || el_pos == element_position_fixed) &&
+					child->get_css_top().is_predefined() && child->get_css_bottom().is_predefined()))
+				{
+					child->shift_y(shift);
+				} else if (child->get_display() == display_inline)
+				{
+					// inline elements take their extents from the moved line boxes
+					size child_size;
+					child->calc_document_size(child_size);
+					child->calc_ink_overflow();
+				}
 			}
 		}
+		else if (child == el)
+		{
+			found = true;
+		}
+	}
+	for (auto& fb : m_floats_left)
+	{
+		if (fb.pos.top() >= old_bottom)
+		{
+			fb.pos.y += shift;
+		}
+	}
+	for (auto& fb : m_floats_right)
+	{
+		if (fb.pos.top() >= old_bottom)
+		{
+			fb.pos.y += shift;
+		}
+	}
+	m_cahe_line_left.invalidate();
+	m_cahe_line_right.invalidate();
+
+	int predefined_height = 0;
+	if (get_predefined_height(predefined_height))
+	{
+		return;
+	}
+
+	int old_self_bottom = bottom();
+	int old_self_margin = m_box ? m_box->bottom_margin() : 0;
+	if (el_box + 1 == m_boxes.size() && collapse_bottom_margin())
+	{
+		// the last child's bottom margin collapses with ours
+		m_layout_height	+= dy - (new_margin - old_margin);
+		m_margins.bottom = std::max(new_margin, m_css_margins.bottom.calc_percent(m_layout_width));
 	}
 	else
 	{
-		for (int row = 0; row < m_grid->rows_count(); row++)
+		m_layout_height += shift;
+	}
+	// the root box may be stretched to the window, so the laid out height is the base
+	m_pos.height		= m_layout_height;
+	m_layout_margins	= m_margins;
+
+	element::ptr el_parent = parent();
+	if (el_parent)
+	{
+		el_parent->update_child_height(shared_from_this(), bottom() - old_self_bottom, old_self_margin);
+	}
+}
+
+int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pass /*= false*/)
+{
+	trace_span span("layout", "render_table", this);
+	if (!m_grid) return 0;
+
+	int parent_width = max_width;
+
+	calc_outlines(parent_width);
+
+	m_pos.clear();
+	m_pos.move_to(x, y);
+
+	m_pos.x += content_margins_left();
+	m_pos.y += content_margins_top();
+
+	def_value<int>	block_width(0);
+
+	if (!m_css_width.is_predefined())
+	{
+		max_width = block_width = calc_width(parent_width) - m_padding.width() - m_borders.width();
+	}
+	else
+	{
+		if (max_width)
 		{
-			for (int col = 0; col < m_grid->cols_count(); col++)
+			max_width -= content_margins_left() + content_margins_right();
+		}
+	}
+
+	// Calculate table spacing
+	int table_width_spacing = 0;
+	if (m_border_collapse == border_collapse_separate)
+	{
+		table_width_spacing = m_border_spacing_x * (m_grid->cols_count() + 1);
+	}
+	else
+	{
+		table_width_spacing = 0;
+
+		if (m_grid->cols_count())
+		{
+			table_width_spacing -= std::min(border_left(), m_grid->column(0).border_left);
+			table_width_spacing -= std::min(border_right(), m_grid->column(m_grid->cols_count() - 1).border_right);
+		}
+
+		for (int col = 1; col < m_grid->cols_count(); col++)
+		{
+			table_width_spacing -= std::min(m_grid->column(col).border_left, m_grid->column(col - 1).border_right);
+		}
+	}
+
+
+	// cells are independent formatting contexts, so they can be rendered in parallel
+	document::ptr doc = get_document();
+	int cols_count = m_grid->cols_count();
+
+	int table_width = 0;
+	int min_table_width = 0;
+	int max_table_width = 0;
+
+	bool fixed_layout = m_table_layout == table_layout_fixed && !block_width.is_default();
+	if (fixed_layout)
+	{
+		// the fixed layout takes the column widths from the first row,
+		// so every cell is rendered only once at its final width below
+		table_width = m_grid->calc_fixed_table_width(block_width - table_width_spacing);
+		min_table_width = max_table_width = table_width;
+	}
+	else
+	{
+		// Calculate the minimum content width (MCW) of each cell: the formatted content may span any number of lines but may not overflow the cell box. 
+		// If the specified 'width' (W) of the cell is greater than MCW, W is the minimum cell width. A value of 'auto' means that MCW is the minimum 
+		// cell width.
+		// 
+		// Also, calculate the "maximum" cell width of each cell: formatting the content without breaking lines other than where explicit line breaks occur.
+
+		if (m_grid->cols_count() == 1 && !block_width.is_default())
+		{
+			doc->run_tasks(m_grid->rows_count(), [&](int row)
+			{
+				table_cell* cell = m_grid->cell(0, row);
+				if (cell && cell->el)
+				{
+					cell->min_width = cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
+					cell->el->m_pos.width = cell->min_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+				}
+			});
+		}
+		else
+		{
+			doc->run_tasks(m_grid->rows_count() * cols_count, [&](int i)
 			{
+				int row = i / cols_count;
+				int col = i % cols_count;
 				table_cell* cell = m_grid->cell(col, row);
 				if (cell && cell->el)
 				{
@@ -4275,77 +5389,73 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 						cell->max_width = cell->el->render(0, 0, max_width - table_width_spacing);
 					}
 				}
-			}
+			});
 		}
-	}
 
-	// For each column, determine a maximum and minimum column width from the cells that span only that column. 
-	// The minimum is that required by the cell with the largest minimum cell width (or the column 'width', whichever is larger). 
-	// The maximum is that required by the cell with the largest maximum cell width (or the column 'width', whichever is larger).
+		// For each column, determine a maximum and minimum column width from the cells that span only that column. 
+		// The minimum is that required by the cell with the largest minimum cell width (or the column 'width', whichever is larger). 
+		// The maximum is that required by the cell with the largest maximum cell width (or the column 'width', whichever is larger).
 
-	for (int col = 0; col < m_grid->cols_count(); col++)
-	{
-		m_grid->column(col).max_width = 0;
-		m_grid->column(col).min_width = 0;
-		for (int row = 0; row < m_grid->rows_count(); row++)
+		for (int col = 0; col < m_grid->cols_count(); col++)
 		{
-			if (m_grid->cell(col, row)->colspan <= 1)
+			m_grid->column(col).max_width = 0;
+			m_grid->column(col).min_width = 0;
+			for (int row = 0; row < m_grid->rows_count(); row++)
 			{
-				m_grid->column(col).max_width = std::max(m_grid->column(col).max_width, m_grid->cell(col, row)->max_width);
-				m_grid->column(col).min_width = std::max(m_grid->column(col).min_width, m_grid->cell(col, row)->min_width);
+				if (m_grid->cell(col, row)->colspan <= 1)
+				{
+					m_grid->column(col).max_width = std::max(m_grid->column(col).max_width, m_grid->cell(col, row)->max_width);
+					m_grid->column(col).min_width = std::max(m_grid->column(col).min_width, m_grid->cell(col, row)->min_width);
+				}
 			}
 		}
-	}
 
-	// For each cell that spans more than one column, increase the minimum widths of the columns it spans so that together, 
-	// they are at least as wide as the cell. Do the same for the maximum widths. 
-	// If possible, widen all spanned columns by approximately the same amount.
+		// For each cell that spans more than one column, increase the minimum widths of the columns it spans so that together, 
+		// they are at least as wide as the cell. Do the same for the maximum widths. 
+		// If possible, widen all spanned columns by approximately the same amount.
 
-	for (int col = 0; col < m_grid->cols_count(); col++)
-	{
-		for (int row = 0; row < m_grid->rows_count(); row++)
+		for (int col = 0; col < m_grid->cols_count(); col++)
 		{
-			if (m_grid->cell(col, row)->colspan > 1)
+			for (int row = 0; row < m_grid->rows_count(); row++)
 			{
-				int max_total_width = m_grid->column(col).max_width;
-				int min_total_width = m_grid->column(col).min_width;
-				for (int col2 = col + 1; col2 < col + m_grid->cell(col, row)->colspan; col2++)
-				{
-					max_total_width += m_grid->column(col2).max_width;
-					min_total_width += m_grid->column(col2).min_width;
-				}
-				if (min_total_width < m_grid->cell(col, row)->min_width)
-				{
-					m_grid->distribute_min_width(m_grid->cell(col, row)->min_width - min_total_width, col, col + m_grid->cell(col, row)->colspan - 1);
-				}
-				if (max_total_width < m_grid->cell(col, row)->max_width)
+				if (m_grid->cell(col, row)->colspan > 1)
 				{
-					m_grid->distribute_max_width(m_grid->cell(col, row)->max_width - max_total_width, col, col + m_grid->cell(col, row)->colspan - 1);
+					int max_total_width = m_grid->column(col).max_width;
+					int min_total_width = m_grid->column(col).min_width;
+					for (int col2 = col + 1; col2 < col + m_grid->cell(col, row)->colspan; col2++)
+					{
+						max_total_width += m_grid->column(col2).max_width;
+						min_total_width += m_grid->column(col2).min_width;
+					}
+					if (min_total_width < m_grid->cell(col, row)->min_width)
+					{
+						m_grid->distribute_min_width(m_grid->cell(col, row)->min_width - min_total_width, col, col + m_grid->cell(col, row)->colspan - 1);
+					}
+					if (max_total_width < m_grid->cell(col, row)->max_width)
+					{
+						m_grid->distribute_max_width(m_grid->cell(col, row)->max_width - max_total_width, col, col + m_grid->cell(col, row)->colspan - 1);
+					}
 				}
 			}
 		}
-	}
 
-	// If the 'table' or 'inline-table' element's 'width' property has a computed value (W) other than 'auto', the used width is the 
-	// greater of W, CAPMIN, and the minimum width required by all the columns plus cell spacing or borders (MIN). 
-	// If the used width is greater than MIN, the extra width should be distributed over the columns.
-	//
-	// If the 'table' or 'inline-table' element has 'width: auto', the used width is the greater of the table's containing block width, 
-	// CAPMIN, and MIN. However, if either CAPMIN or the maximum width required by the columns plus cell spacing or borders (MAX) is 
-	// less than that of the containing block, use max(MAX, CAPMIN).
+		// If the 'table' or 'inline-table' element's 'width' property has a computed value (W) other than 'auto', the used width is the 
+		// greater of W, CAPMIN, and the minimum width required by all the columns plus cell spacing or borders (MIN). 
+		// If the used width is greater than MIN, the extra width should be distributed over the columns.
+		//
+		// If the 'table' or 'inline-table' element has 'width: auto', the used width is the greater of the table's containing block width, 
+		// CAPMIN, and MIN. However, if either CAPMIN or the maximum width required by the columns plus cell spacing or borders (MAX) is 
+		// less than that of the containing block, use max(MAX, CAPMIN).
 
 
-	int table_width = 0;
-	int min_table_width = 0;
-	int max_table_width = 0;
-
-	if (!block_width.is_default())
-	{
-		table_width = m_grid->calc_table_width(block_width - table_width_spacing, false, min_table_width, max_table_width);
-	}
-	else
-	{
-		table_width = m_grid->calc_table_width(max_width - table_width_spacing, true, min_table_width, max_table_width);
+		if (!block_width.is_default())
+		{
+			table_width = m_grid->calc_table_width(block_width - table_width_spacing, false, min_table_width, max_table_width);
+		}
+		else
+		{
+			table_width = m_grid->calc_table_width(max_width - table_width_spacing, true, min_table_width, max_table_width);
+		}
 	}
 
 	min_table_width += table_width_spacing;
@@ -4356,6 +5466,33 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 	bool row_span_found = false;
 
 	// render cells with computed width
+	doc->run_tasks(m_grid->rows_count() * cols_count, [&](int i)
+	{
+		int row = i / cols_count;
+		int col = i % cols_count;
+		table_cell* cell = m_grid->cell(col, row);
+		if (cell->el)
+		{
+			int span_col = col + cell->colspan - 1;
+			if (span_col >= m_grid->cols_count())
+			{
+				span_col = m_grid->cols_count() - 1;
+			}
+			int cell_width = m_grid->column(span_col).right - m_grid->column(col).left;
+
+			// a fixed layout cell was not rendered while measuring, so its content is laid out here every time
+			if (fixed_layout || cell->el->m_pos.width != cell_width - cell->el->content_margins_left() - cell->el->content_margins_right())
+			{
+				cell->el->render(m_grid->column(col).left, 0, cell_width);
+				cell->el->m_pos.width = cell_width - cell->el->content_margins_left() - cell->el->content_margins_right();
+			}
+			else
+			{
+				cell->el->m_pos.x = m_grid->column(col).left + cell->el->content_margins_left();
+			}
+		}
+	});
+
 	for (int row = 0; row < m_grid->rows_count(); row++)
 	{
 		m_grid->row(row).height = 0;
@@ -4364,23 +5501,6 @@ int litehtml::html_tag::render_table(int x, int y, int max_width, bool second_pa
 			table_cell* cell = m_grid->cell(col, row);
 			if (cell->el)
 			{
-				int span_col = col + cell->colspan - 1;
-				if (span_col >= m_grid->cols_count())
-				{
-					span_col = m_grid->cols_count() - 1;
-				}
-				int cell_width = m_grid->column(span_col).right - m_grid->column(col).left;
-
-				if (cell->el->m_pos.width != cell_width - cell->el->content_margins_left() - cell->el->content_margins_right())
-				{
-					cell->el->render(m_grid->column(col).left, 0, cell_width);
-					cell->el->m_pos.width = cell_width - cell->el->content_margins_left() - cell->el->content_margins_right();
-				}
-				else
-				{
-					cell->el->m_pos.x = m_grid->column(col).left + cell->el->content_margins_left();
-				}
-
 				if (cell->rowspan <= 1)
 				{
 					m_grid->row(row).height = std::max(m_grid->row(row).height, cell->el->height());
@@ -4536,18 +5656,13 @@ void litehtml::html_tag::draw_children_box(uint_ptr hdc, int x, int y, const pos
 
 	document::ptr doc = get_document();
 
-	if (m_overflow > overflow_visible)
+	bool clipped = set_children_clip(x, y);
+	// children outside the overflow clip can not reach any pixels
+	position clip_box;
+	if (clipped && !clip_to_children(shared_from_this(), x, y, clip_box, clip))
 	{
-		position border_box = pos;
-		border_box += m_padding;
-		border_box += m_borders;
-
-		border_radiuses bdr_radius = m_css_borders.radius.calc_percents(border_box.width, border_box.height);
-
-		bdr_radius -= m_borders;
-		bdr_radius -= m_padding;
-
-		doc->container()->set_clip(pos, bdr_radius, true, true);
+		doc->container()->del_clip();
+		return;
 	}
 
 	position browser_wnd;
@@ -4557,7 +5672,7 @@ void litehtml::html_tag::draw_children_box(uint_ptr hdc, int x, int y, const pos
 	for (auto& item : m_children)
 	{
 		el = item;
-		if (el->is_visible())
+		if (el->is_visible() && el->is_ink_visible(pos.x, pos.y, clip))
 		{
 			switch (flag)
 			{
@@ -4628,7 +5743,7 @@ void litehtml::html_tag::draw_children_box(uint_ptr hdc, int x, int y, const pos
 		}
 	}
 
-	if (m_overflow > overflow_visible)
+	if (clipped)
 	{
 		doc->container()->del_clip();
 	}
@@ -4641,7 +5756,21 @@ void litehtml::html_tag::draw_children_table(uint_ptr hdc, int x, int y, const p
 	position pos = m_pos;
 	pos.x += x;
 	pos.y += y;
-	for (int row = 0; row < m_grid->rows_count(); row++)
+
+	int first_row = 0;
+	int last_row = m_grid->rows_count() - 1;
+	if (m_cells_static)
+	{
+		if (flag == draw_positioned)
+		{
+			return;
+		}
+		if (clip && !m_grid->find_rows(clip->top() - pos.y, clip->bottom() - pos.y, first_row, last_row))
+		{
+			return;
+		}
+	}
+	for (int row = first_row; row <= last_row; row++)
 	{
 		if (flag == draw_block)
 		{
@@ -4650,7 +5779,7 @@ void litehtml::html_tag::draw_children_table(uint_ptr hdc, int x, int y, const p
 		for (int col = 0; col < m_grid->cols_count(); col++)
 		{
 			table_cell* cell = m_grid->cell(col, row);
-			if (cell->el)
+			if (cell->el && cell->el->is_ink_visible(pos.x, pos.y, clip))
 			{
 				if (flag == draw_block)
 				{
@@ -4661,3 +5790,43 @@ void litehtml::html_tag::draw_children_table(uint_ptr hdc, int x, int y, const p
 		}
 	}
 }
+
+void litehtml::html_tag::add_memory_usage(memory_usage& usage) const
+{
+	add_tag_usage(usage, sizeof(html_tag));
+}
+
+void litehtml::html_tag::add_tag_usage(memory_usage& usage, size_t object_size) const
+{
+	size_t bytes = memory_usage::string_bytes(m_tag) + memory_usage::string_vector_bytes(m_class_values) + memory_usage::string_vector_bytes(m_pseudo_classes);
+	bytes += (m_floats_left.capacity() + m_floats_right.capacity()) * sizeof(floated_box);
+	bytes += m_positioned.capacity() * sizeof(element::ptr) + m_z_order.capacity() * sizeof(m_z_order[0]);
+	bytes += m_hit_rows.capacity() * sizeof(m_hit_rows[0]) + m_hit_always.capacity() * sizeof(int);
+	for(const auto& row : m_hit_rows)
+	{
+		bytes += row.capacity() * sizeof(int);
+	}
+	add_element_usage(usage, m_tag.empty() ? _t("#anonymous") : m_tag.c_str(), object_size).bytes += bytes;
+
+	usage.styles.add(1, m_style.memory_size() + memory_usage::string_bytes(m_bg.m_image) + memory_usage::string_bytes(m_bg.m_baseurl));
+	usage.attributes.add(m_attrs.size(), memory_usage::string_map_bytes(m_attrs));
+	usage.used_selectors.add(m_used_styles.size(), m_used_styles.capacity() * sizeof(used_selector::ptr) + m_used_styles.size() * sizeof(used_selector));
+	usage.boxes.add(0, m_boxes.capacity() * sizeof(box::ptr));
+	usage.boxes.add(0, (m_spare_line_boxes.capacity() + m_spare_block_boxes.capacity()) * sizeof(box::ptr));
+	for(const auto& bx : m_boxes)
+	{
+		usage.boxes.add(1, bx->memory_size());
+	}
+	for(const auto& bx : m_spare_line_boxes)
+	{
+		usage.boxes.add(1, bx->memory_size());
+	}
+	for(const auto& bx : m_spare_block_boxes)
+	{
+		usage.boxes.add(1, bx->memory_size());
+	}
+	if(m_grid)
+	{
+		usage.table_grids.add(1, m_grid->memory_size());
+	}
+}
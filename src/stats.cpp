@@ -0,0 +1,205 @@
+#include "html.h"
+#include "stats.h"
+#include "css_selector.h"
+#include "utf8_strings.h"
+#include <algorithm>
+#include <stdio.h>
+
+#ifndef LITEHTML_NO_STATS
+thread_local litehtml::document_stats* litehtml::current_stats = 0;
+thread_local litehtml::selector_profile* litehtml::current_selector_profile = 0;
+#endif
+
+litehtml::document_stats::document_stats()
+{
+	render_time			= 0;
+	render_count		= 0;
+	draw_time			= 0;
+	draw_count			= 0;
+	selectors_tested	= 0;
+	selectors_matched	= 0;
+	text_width_calls	= 0;
+	fonts_created		= 0;
+	element_renders		= 0;
+	line_boxes			= 0;
+	block_boxes			= 0;
+}
+
+void litehtml::document_stats::add_counters(const document_stats& val)
+{
+	for(std::map<tstring, int>::const_iterator i = val.elements.begin(); i != val.elements.end(); i++)
+	{
+		elements[i->first] += i->second;
+	}
+	selectors_tested	+= val.selectors_tested;
+	selectors_matched	+= val.selectors_matched;
+	text_width_calls	+= val.text_width_calls;
+	fonts_created		+= val.fonts_created;
+	element_renders		+= val.element_renders;
+	line_boxes			+= val.line_boxes;
+	block_boxes			+= val.block_boxes;
+	for(std::unordered_map<const element*, int>::const_iterator i = val.renders_by_element.begin(); i != val.renders_by_element.end(); i++)
+	{
+		renders_by_element[i->first] += i->second;
+	}
+}
+
+int litehtml::document_stats::max_element_renders() const
+{
+	int ret = 0;
+	for(std::unordered_map<const element*, int>::const_iterator i = renders_by_element.begin(); i != renders_by_element.end(); i++)
+	{
+		ret = std::max(ret, i->second);
+	}
+	return ret;
+}
+
+void litehtml::selector_profile::clear()
+{
+	m_entries.clear();
+	m_current = 0;
+}
+
+size_t litehtml::selector_profile::size() const
+{
+	return m_entries.size();
+}
+
+const litehtml::selector_profile::entry* litehtml::selector_profile::find(const css_selector* selector) const
+{
+	std::unordered_map<const css_selector*, entry>::const_iterator i = m_entries.find(selector);
+	if(i != m_entries.end())
+	{
+		return &i->second;
+	}
+	return 0;
+}
+
+void litehtml::selector_profile::top(size_t count, std::vector<const entry*>& entries) const
+{
+	entries.clear();
+	for(std::unordered_map<const css_selector*, entry>::const_iterator i = m_entries.begin(); i != m_entries.end(); i++)
+	{
+		entries.push_back(&i->second);
+	}
+	std::sort(entries.begin(), entries.end(), [](const entry* left, const entry* right)
+	{
+		if(left->counters.time != right->counters.time)
+		{
+			return left->counters.time > right->counters.time;
+		}
+		return left->counters.hops > right->counters.hops;
+	});
+	if(entries.size() > count)
+	{
+		entries.resize(count);
+	}
+}
+
+std::string litehtml::selector_profile::report(size_t count) const
+{
+	std::vector<const entry*> entries;
+	top(count, entries);
+
+	std::string ret = "    time_us    attempts     matches        hops  selector  [origin]\n";
+	char buf[128];
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		const selector_counters& counters = entries[i]->counters;
+		snprintf(buf, sizeof(buf), "%11.1f %11lld %11lld %11lld  ", counters.time / 1000.0, counters.attempts, counters.matches, counters.hops);
+		ret += buf;
+		ret += (const char*) litehtml_to_utf8(entries[i]->source.c_str());
+		ret += "  [";
+		ret += entries[i]->origin.empty() ? "inline" : (const char*) litehtml_to_utf8(entries[i]->origin.c_str());
+		ret += "]\n";
+	}
+	return ret;
+}
+
+litehtml::selector_profile::entry* litehtml::selector_profile::begin_select(const css_selector& selector)
+{
+	if(m_current)
+	{
+		m_current->counters.hops++;
+		return 0;
+	}
+	std::unordered_map<const css_selector*, entry>::iterator i = m_entries.find(&selector);
+	if(i == m_entries.end())
+	{
+		// the texts are copied, the style sheet may go away before the report
+		entry en;
+#ifndef LITEHTML_NO_STATS
+		en.source = selector.m_source;
+		en.origin = selector.m_origin;
+#endif
+		i = m_entries.insert(std::make_pair(&selector, en)).first;
+	}
+	m_current = &i->second;
+	m_current->counters.attempts++;
+	return m_current;
+}
+
+void litehtml::selector_profile::end_select(entry* en, bool matched, long long time)
+{
+	m_current = 0;
+	if(matched)
+	{
+		en->counters.matches++;
+	}
+	en->counters.time += time;
+}
+
+size_t litehtml::memory_usage::total_bytes() const
+{
+	size_t ret = 0;
+	for(std::map<tstring, memory_item>::const_iterator i = elements.begin(); i != elements.end(); i++)
+	{
+		ret += i->second.bytes;
+	}
+	ret += styles.bytes + attributes.bytes + texts.bytes + transformed_texts.bytes + used_selectors.bytes;
+	ret += boxes.bytes + table_grids.bytes + fonts.bytes + stylesheets.bytes;
+	return ret;
+}
+
+size_t litehtml::memory_usage::string_bytes(const tstring& str)
+{
+	// short strings are kept inside the string object
+	static const size_t local_capacity = tstring().capacity();
+	if(str.capacity() <= local_capacity)
+	{
+		return 0;
+	}
+	return (str.capacity() + 1) * sizeof(tchar_t);
+}
+
+size_t litehtml::memory_usage::string_vector_bytes(const string_vector& strings)
+{
+	size_t ret = strings.capacity() * sizeof(tstring);
+	for(string_vector::const_iterator i = strings.begin(); i != strings.end(); i++)
+	{
+		ret += string_bytes(*i);
+	}
+	return ret;
+}
+
+size_t litehtml::memory_usage::string_map_bytes(const string_map& strings)
+{
+	size_t ret = 0;
+	for(string_map::const_iterator i = strings.begin(); i != strings.end(); i++)
+	{
+		ret += map_node_bytes(sizeof(string_map::value_type)) + string_bytes(i->first) + string_bytes(i->second);
+	}
+	return ret;
+}
+
+size_t litehtml::memory_usage::map_node_bytes(size_t value_size)
+{
+	// color and three links of a red-black tree node
+	return value_size + 4 * sizeof(void*);
+}
+
+size_t litehtml::memory_usage::shared_object_bytes(size_t object_size)
+{
+	// make_shared keeps the vtable pointer and both reference counts next to the object
+	return object_size + sizeof(void*) + 2 * sizeof(int);
+}
@@ -1,5 +1,6 @@
 #include "html.h"
 #include "style.h"
+#include "stats.h"
 #include <functional>
 #include <algorithm>
 #ifndef WINCE
@@ -25,6 +26,22 @@ litehtml::style::~style()
 
 }
 
+const litehtml::tchar_t* litehtml::style::get_property(const tchar_t* name) const
+{
+	if(name)
+	{
+		// the map needs a tstring key, a long property name would allocate one on every lookup
+		static thread_local tstring key;
+		key = name;
+		props_map::const_iterator f = m_properties.find(key);
+		if(f != m_properties.end())
+		{
+			return f->second.m_value.c_str();
+		}
+	}
+	return 0;
+}
+
 void litehtml::style::parse( const tchar_t* txt, const tchar_t* baseurl )
 {
 	std::vector<tstring> properties;
@@ -646,3 +663,13 @@ void litehtml::style::remove_property( const tstring& name, bool important )
 		}
 	}
 }
+
+size_t litehtml::style::memory_size() const
+{
+	size_t ret = 0;
+	for(props_map::const_iterator i = m_properties.begin(); i != m_properties.end(); i++)
+	{
+		ret += memory_usage::map_node_bytes(sizeof(props_map::value_type)) + memory_usage::string_bytes(i->first) + memory_usage::string_bytes(i->second.m_value);
+	}
+	return ret;
+}
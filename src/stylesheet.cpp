@@ -6,15 +6,35 @@
 
 void litehtml::css::parse_stylesheet(const tchar_t* str, const tchar_t* baseurl, const std::shared_ptr<document>& doc, const media_query_list::ptr& media)
 {
-	tstring text = str;
+	trace_span span("parse", "parse_stylesheet", "url", baseurl);
+	tstring text;
 
-	// remove comments
-	tstring::size_type c_start = text.find(_t("/*"));
-	while(c_start != tstring::npos)
+	// remove comments in one pass, a slash left before a comment still joins the star after it
+	size_t len = t_strlen(str);
+	text.reserve(len);
+	for(size_t i = 0; i < len;)
 	{
-		tstring::size_type c_end = text.find(_t("*/"), c_start + 2);
-		text.erase(c_start, c_end - c_start + 2);
-		c_start = text.find(_t("/*"));
+		size_t body = tstring::npos;
+		if(str[i] == _t('/') && str[i + 1] == _t('*'))
+		{
+			body = i + 2;
+		} else if(str[i] == _t('*') && !text.empty() && text.back() == _t('/'))
+		{
+			text.pop_back();
+			body = i + 1;
+		}
+		if(body == tstring::npos)
+		{
+			text += str[i++];
+			continue;
+		}
+		const tchar_t* c_end = t_strstr(str + body, _t("*/"));
+		if(!c_end)
+		{
+			// an unclosed comment runs to the end of the stylesheet
+			break;
+		}
+		i = c_end - str + 2;
 	}
 
 	tstring::size_type pos = text.find_first_not_of(_t(" \n\r\t"));
@@ -54,7 +74,7 @@ void litehtml::css::parse_stylesheet(const tchar_t* str, const tchar_t* baseurl,
 			style::ptr st = std::make_shared<style>();
 			st->add(text.substr(style_start + 1, style_end - style_start - 1).c_str(), baseurl);
 
-			parse_selectors(text.substr(pos, style_start - pos), st, media);
+			parse_selectors(text.substr(pos, style_start - pos), st, media, baseurl);
 
 			if(media && doc)
 			{
@@ -99,7 +119,7 @@ void litehtml::css::parse_css_url( const tstring& str, tstring& url )
 	}
 }
 
-bool litehtml::css::parse_selectors( const tstring& txt, const litehtml::style::ptr& styles, const media_query_list::ptr& media )
+bool litehtml::css::parse_selectors( const tstring& txt, const litehtml::style::ptr& styles, const media_query_list::ptr& media, const tchar_t* baseurl )
 {
 	tstring selector = txt;
 	trim(selector);
@@ -115,6 +135,13 @@ bool litehtml::css::parse_selectors( const tstring& txt, const litehtml::style::
 		trim(*tok);
 		if(selector->parse(*tok))
 		{
+#ifndef LITEHTML_NO_STATS
+			selector->m_source = *tok;
+			if(baseurl)
+			{
+				selector->m_origin = baseurl;
+			}
+#endif
 			selector->calc_specificity();
 			add_selector(selector);
 			added_something = true;
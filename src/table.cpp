@@ -10,24 +10,34 @@ void litehtml::table_grid::add_cell(element::ptr& el)
 	cell.rowspan	= t_atoi(el->get_attr(_t("rowspan"), _t("1")));
 	cell.borders	= el->get_borders();
 
-	while( is_rowspanned( (int) m_cells.size() - 1, (int) m_cells.back().size() ) )
+	int row = (int) m_row_start.size() - 1;
+	while( is_rowspanned( row, (int) m_cells.size() - m_row_start.back() ) )
 	{
-		m_cells.back().push_back(table_cell());
+		m_cells.push_back(table_cell());
 	}
 
-	m_cells.back().push_back(cell);
+	int col = (int) m_cells.size() - m_row_start.back();
+	if(cell.rowspan > 1)
+	{
+		m_max_rowspan = std::max(m_max_rowspan, cell.rowspan);
+		if(col >= (int) m_span_end.size())
+		{
+			m_span_end.resize(col + 1, -1);
+		}
+		m_span_end[col] = std::max(m_span_end[col], row + cell.rowspan - 1);
+	}
+
+	m_cells.push_back(cell);
 	for(int i = 1; i < cell.colspan; i++)
 	{
-		table_cell empty_cell;
-		m_cells.back().push_back(empty_cell);
+		m_cells.push_back(table_cell());
 	}
 }
 
 
 void litehtml::table_grid::begin_row(element::ptr& row)
 {
-	std::vector<table_cell> r;
-	m_cells.push_back(r);
+	m_row_start.push_back((int) m_cells.size());
 	
 	m_rows.push_back(table_row(0, row));
 
@@ -36,37 +46,17 @@ void litehtml::table_grid::begin_row(element::ptr& row)
 
 bool litehtml::table_grid::is_rowspanned( int r, int c )
 {
-	for(int row = r - 1; row >= 0; row--)
-	{
-		if(c < (int) m_cells[row].size())
-		{
-			if(m_cells[row][c].rowspan > 1)
-			{
-				if(m_cells[row][c].rowspan >= r - row + 1)
-				{
-					return true;
-				}
-			}
-		}
-	}
-	return false;
+	return c < (int) m_span_end.size() && m_span_end[c] >= r;
 }
 
 void litehtml::table_grid::finish()
 {
-	m_rows_count	= (int) m_cells.size();
+	m_rows_count	= (int) m_row_start.size();
 	m_cols_count	= 0;
-	for(int i = 0; i < (int) m_cells.size(); i++)
-	{
-		m_cols_count = std::max(m_cols_count, (int) m_cells[i].size());
-	}
-	for(int i = 0; i < (int) m_cells.size(); i++)
+	for(int row = 0; row < m_rows_count; row++)
 	{
-		for(int j = (int) m_cells[i].size(); j < m_cols_count; j++)
-		{
-			table_cell empty_cell;
-			m_cells[i].push_back(empty_cell);
-		}
+		int row_end = row + 1 < m_rows_count ? m_row_start[row + 1] : (int) m_cells.size();
+		m_cols_count = std::max(m_cols_count, row_end - m_row_start[row]);
 	}
 
 	m_columns.clear();
@@ -75,73 +65,108 @@ void litehtml::table_grid::finish()
 		m_columns.push_back(table_column(0, 0));
 	}
 
-	for(int col = 0; col < m_cols_count; col++)
+	// pack the rows into the grid and collect the column and row borders in one pass
+	std::vector<table_cell> cells;
+	cells.reserve(m_rows_count * m_cols_count);
+	for(int row = 0; row < m_rows_count; row++)
 	{
-		for(int row = 0; row < m_rows_count; row++)
+		int row_end = row + 1 < m_rows_count ? m_row_start[row + 1] : (int) m_cells.size();
+		for(int col = 0; col < m_cols_count; col++)
 		{
-			if(cell(col, row)->el)
+			int idx = m_row_start[row] + col;
+			if(idx < row_end)
+			{
+				cells.push_back(m_cells[idx]);
+			} else
+			{
+				cells.push_back(table_cell());
+			}
+
+			const table_cell& cl = cells.back();
+			if(cl.el)
 			{
 				// find minimum left border width
 				if(m_columns[col].border_left)
 				{
-					m_columns[col].border_left = std::min(m_columns[col].border_left, cell(col, row)->borders.left);
+					m_columns[col].border_left = std::min(m_columns[col].border_left, cl.borders.left);
 				} else
 				{
-					m_columns[col].border_left = cell(col, row)->borders.left;
+					m_columns[col].border_left = cl.borders.left;
 				}
 				// find minimum right border width
 				if(m_columns[col].border_right)
 				{
-					m_columns[col].border_right = std::min(m_columns[col].border_right, cell(col, row)->borders.right);
+					m_columns[col].border_right = std::min(m_columns[col].border_right, cl.borders.right);
 				} else
 				{
-					m_columns[col].border_right = cell(col, row)->borders.right;
+					m_columns[col].border_right = cl.borders.right;
 				}
 				// find minimum top border width
 				if(m_rows[row].border_top)
 				{
-					m_rows[row].border_top = std::min(m_rows[row].border_top, cell(col, row)->borders.top);
+					m_rows[row].border_top = std::min(m_rows[row].border_top, cl.borders.top);
 				} else
 				{
-					m_rows[row].border_top = cell(col, row)->borders.top;
+					m_rows[row].border_top = cl.borders.top;
 				}
 				// find minimum bottom border width
 				if(m_rows[row].border_bottom)
 				{
-					m_rows[row].border_bottom = std::min(m_rows[row].border_bottom, cell(col, row)->borders.bottom);
+					m_rows[row].border_bottom = std::min(m_rows[row].border_bottom, cl.borders.bottom);
 				} else
 				{
-					m_rows[row].border_bottom = cell(col, row)->borders.bottom;
+					m_rows[row].border_bottom = cl.borders.bottom;
 				}
-			}
 
-			if(cell(col, row)->el && cell(col, row)->colspan <= 1)
-			{
-				if (!cell(col, row)->el->get_css_width().is_predefined() && m_columns[col].css_width.is_predefined())
+				if(cl.colspan <= 1)
 				{
-					m_columns[col].css_width = cell(col, row)->el->get_css_width();
+					if (!cl.el->get_css_width().is_predefined() && m_columns[col].css_width.is_predefined())
+					{
+						m_columns[col].css_width = cl.el->get_css_width();
+					}
 				}
 			}
 		}
 	}
+	m_cells.swap(cells);
+	m_row_start.clear();
+	m_span_end.clear();
 
-	for(int col = 0; col < m_cols_count; col++)
+	// the fixed table layout uses the widths of the first row only
+	if(m_rows_count)
 	{
-		for(int row = 0; row < m_rows_count; row++)
+		for(int col = 0; col < m_cols_count; col++)
 		{
-			if(cell(col, row)->el)
+			table_cell* first = cell(col, 0);
+			if(first->el && !first->el->get_css_width().is_predefined())
 			{
-				cell(col, row)->el->set_css_width(m_columns[col].css_width);
+				css_length w = first->el->get_css_width();
+				if(first->colspan > 1)
+				{
+					w.set_value(w.val() / first->colspan, w.units());
+				}
+				for(int span_col = col; span_col < col + first->colspan && span_col < m_cols_count; span_col++)
+				{
+					m_columns[span_col].css_fixed_width = w;
+				}
 			}
 		}
 	}
+
+	for(int i = 0; i < (int) m_cells.size(); i++)
+	{
+		if(m_cells[i].el)
+		{
+			m_cells[i].el->set_css_width(m_columns[i % m_cols_count].css_width);
+		}
+	}
 }
 
 litehtml::table_cell* litehtml::table_grid::cell( int t_col, int t_row )
 {
 	if(t_col >= 0 && t_col < m_cols_count && t_row >= 0 && t_row < m_rows_count)
 	{
-		return &m_cells[t_row][t_col];
+		return &m_cells[t_row * m_cols_count + t_col];
 	}
 	return 0;
 }
@@ -379,15 +404,104 @@ int litehtml::table_grid::calc_table_width(int block_width, bool is_auto, int& m
 	return cur_width;
 }
 
+int litehtml::table_grid::calc_fixed_table_width(int block_width)
+{
+	int cur_width = 0;
+	int auto_count = 0;
+
+	for(int col = 0; col < m_cols_count; col++)
+	{
+		if(!m_columns[col].css_fixed_width.is_predefined())
+		{
+			m_columns[col].width = m_columns[col].css_fixed_width.calc_percent(block_width);
+			cur_width += m_columns[col].width;
+		} else
+		{
+			m_columns[col].width = 0;
+			auto_count++;
+		}
+	}
+
+	// the css width of a content-box cell does not include its padding and borders,
+	// a cell spanning several columns splits them between its columns
+	if(m_rows_count)
+	{
+		for(int col = 0; col < m_cols_count; col++)
+		{
+			table_cell* first = cell(col, 0);
+			if(first->el && !m_columns[col].css_fixed_width.is_predefined() && first->el->get_box_sizing() == box_sizing_content_box)
+			{
+				first->el->calc_outlines(block_width);
+				margins paddings = first->el->get_paddings();
+				margins borders = first->el->get_borders();
+				int extra = paddings.left + paddings.right + borders.left + borders.right;
+				int span = std::min(std::max(first->colspan, 1), m_cols_count - col);
+				for(int i = 0; i < span; i++)
+				{
+					int share = extra * (i + 1) / span - extra * i / span;
+					m_columns[col + i].width += share;
+					cur_width += share;
+				}
+			}
+		}
+	}
+
+	if(cur_width < block_width)
+	{
+		// the columns without width share the rest of the table equally,
+		// otherwise the extra width goes to all columns proportionally
+		int extra = block_width - cur_width;
+		int cols = auto_count ? auto_count : m_cols_count;
+		int idx = 0;
+		int sum_width = 0;
+		int added = 0;
+		for(int col = 0; col < m_cols_count; col++)
+		{
+			if(auto_count && !m_columns[col].css_fixed_width.is_predefined())
+			{
+				continue;
+			}
+			int total = 0;
+			if(auto_count || !cur_width)
+			{
+				total = (int) ((long long) extra * (idx + 1) / cols);
+			} else
+			{
+				sum_width += m_columns[col].width;
+				total = (int) ((long long) extra * sum_width / cur_width);
+			}
+			m_columns[col].width += total - added;
+			added = total;
+			idx++;
+		}
+		cur_width = block_width;
+	}
+
+	for(int col = 0; col < m_cols_count; col++)
+	{
+		m_columns[col].min_width = m_columns[col].max_width = m_columns[col].width;
+	}
+	return cur_width;
+}
+
 void litehtml::table_grid::clear()
 {
 	m_rows_count	= 0;
 	m_cols_count	= 0;
 	m_cells.clear();
+	m_row_start.clear();
+	m_span_end.clear();
+	m_max_rowspan	= 1;
 	m_columns.clear();
 	m_rows.clear();
 }
 
+size_t litehtml::table_grid::memory_size() const
+{
+	return sizeof(table_grid) + m_cells.capacity() * sizeof(table_cell) + (m_row_start.capacity() + m_span_end.capacity()) * sizeof(int) +
+		m_columns.capacity() * sizeof(table_column) + m_rows.capacity() * sizeof(table_row);
+}
+
 void litehtml::table_grid::calc_horizontal_positions( margins& table_borders, border_collapse bc, int bdr_space_x)
 {
 	if(bc == border_collapse_separate)
@@ -564,3 +678,33 @@ int& litehtml::table_column_accessor_width::get( table_column& col )
 {
 	return col.width;
 }
+
+bool litehtml::table_grid::find_rows(int top, int bottom, int& first_row, int& last_row)
+{
+	// rows are sorted by position, so the rows intersecting [top, bottom] are found with binary search
+	auto first = std::lower_bound(m_rows.begin(), m_rows.end(), top,
+		[](const table_row& row, int y)
+		{
+			return row.bottom < y;
+		});
+	auto last = std::upper_bound(first, m_rows.end(), bottom,
+		[](int y, const table_row& row)
+		{
+			return y < row.top;
+		});
+	first_row	= (int) (first - m_rows.begin());
+	last_row	= (int) (last - m_rows.begin()) - 1;
+	if(first == last)
+	{
+		// only the spacing between two rows is in the range, cells spanning both rows can still be there
+		if(first == m_rows.begin() || first == m_rows.end())
+		{
+			return false;
+		}
+		last_row	= first_row;
+		first_row	= first_row - 1;
+	}
+	// cells spanning several rows start above the first row
+	first_row	= std::max(0, first_row - (m_max_rowspan - 1));
+	return true;
+}
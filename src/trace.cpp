@@ -0,0 +1,215 @@
+#include "html.h"
+#include "trace.h"
+#include "element.h"
+#include "utf8_strings.h"
+#include <stdio.h>
+
+thread_local litehtml::tracer* litehtml::current_tracer = 0;
+
+static void append_json_string(std::string& out, const litehtml::tchar_t* val)
+{
+	std::string str = (const char*) litehtml_to_utf8(val);
+	out += '"';
+	for(size_t i = 0; i < str.length(); i++)
+	{
+		unsigned char ch = (unsigned char) str[i];
+		if(ch == '"' || ch == '\\')
+		{
+			out += '\\';
+			out += (char) ch;
+		} else if(ch < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", ch);
+			out += buf;
+		} else
+		{
+			out += (char) ch;
+		}
+	}
+	out += '"';
+}
+
+litehtml::tracer::tracer(trace_writer* writer, int min_duration_us)
+{
+	m_writer		= writer;
+	m_min_duration	= (long long) min_duration_us * 1000;
+	m_start			= std::chrono::steady_clock::now();
+	m_first			= true;
+	m_finished		= false;
+	m_writer->write("[\n", 2);
+}
+
+litehtml::tracer::~tracer()
+{
+	finish();
+}
+
+long long litehtml::tracer::now() const
+{
+	return to_trace_time(std::chrono::steady_clock::now());
+}
+
+long long litehtml::tracer::to_trace_time(std::chrono::steady_clock::time_point tp) const
+{
+	return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(tp - m_start).count();
+}
+
+void litehtml::tracer::add_span(const char* category, const char* name, long long start, long long duration, const element* el, const char* arg_name, const tchar_t* arg_value)
+{
+	std::string args;
+	if(el)
+	{
+		const tchar_t* tag = el->get_tagName();
+		args += "\"tag\":";
+		append_json_string(args, tag && tag[0] ? tag : _t("#text"));
+		const tchar_t* id = el->get_attr(_t("id"));
+		if(id)
+		{
+			args += ",\"id\":";
+			append_json_string(args, id);
+		}
+		const tchar_t* cls = el->get_attr(_t("class"));
+		if(cls)
+		{
+			args += ",\"class\":";
+			append_json_string(args, cls);
+		}
+	}
+	if(arg_name && arg_value)
+	{
+		if(!args.empty())
+		{
+			args += ",";
+		}
+		args += "\"";
+		args += arg_name;
+		args += "\":";
+		append_json_string(args, arg_value);
+	}
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	if(m_finished)
+	{
+		return;
+	}
+	// the trace viewer wants small thread ids
+	std::map<std::thread::id, int>::iterator thread = m_threads.find(std::this_thread::get_id());
+	if(thread == m_threads.end())
+	{
+		thread = m_threads.insert(std::make_pair(std::this_thread::get_id(), (int) m_threads.size() + 1)).first;
+	}
+
+	char buf[128];
+	std::string event = m_first ? "{\"name\":\"" : ",\n{\"name\":\"";
+	event += name;
+	event += "\",\"cat\":\"";
+	event += category;
+	snprintf(buf, sizeof(buf), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d", start / 1000.0, duration / 1000.0, thread->second);
+	event += buf;
+	if(!args.empty())
+	{
+		event += ",\"args\":{" + args + "}";
+	}
+	event += "}";
+	m_writer->write(event.c_str(), event.length());
+	m_first = false;
+}
+
+void litehtml::tracer::finish()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	if(!m_finished)
+	{
+		m_writer->write("\n]\n", 3);
+		m_finished = true;
+	}
+}
+
+litehtml::tracing_container::tracing_container(document_container* target) : container_proxy(target)
+{
+}
+
+litehtml::uint_ptr litehtml::tracing_container::create_font(const tchar_t* faceName, int size, int weight, font_style italic, unsigned int decoration, font_metrics* fm)
+{
+	trace_span span("container", "create_font", "face", faceName, true);
+	return m_target->create_font(faceName, size, weight, italic, decoration, fm);
+}
+
+int litehtml::tracing_container::text_width(const tchar_t* text, uint_ptr hFont)
+{
+	trace_span span("container", "text_width", 0);
+	return m_target->text_width(text, hFont);
+}
+
+void litehtml::tracing_container::text_widths(const tchar_t* const* texts, int count, uint_ptr hFont, int* widths)
+{
+	trace_span span("container", "text_widths", 0);
+	m_target->text_widths(texts, count, hFont, widths);
+}
+
+void litehtml::tracing_container::draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos)
+{
+	trace_span span("container", "draw_text", 0);
+	m_target->draw_text(hdc, text, hFont, color, pos);
+}
+
+void litehtml::tracing_container::draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color)
+{
+	trace_span span("container", "draw_text_run", 0);
+	m_target->draw_text_run(hdc, texts, positions, count, hFont, color);
+}
+
+void litehtml::tracing_container::draw_list_marker(uint_ptr hdc, const list_marker& marker)
+{
+	trace_span span("container", "draw_list_marker", 0);
+	m_target->draw_list_marker(hdc, marker);
+}
+
+void litehtml::tracing_container::load_image(const tchar_t* src, const tchar_t* baseurl, bool redraw_on_ready)
+{
+	trace_span span("container", "load_image", "src", src, true);
+	m_target->load_image(src, baseurl, redraw_on_ready);
+}
+
+void litehtml::tracing_container::get_image_size(const tchar_t* src, const tchar_t* baseurl, size& sz)
+{
+	trace_span span("container", "get_image_size", "src", src, true);
+	m_target->get_image_size(src, baseurl, sz);
+}
+
+void litehtml::tracing_container::draw_background(uint_ptr hdc, const background_paint& bg)
+{
+	trace_span span("container", "draw_background", 0);
+	m_target->draw_background(hdc, bg);
+}
+
+void litehtml::tracing_container::draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root)
+{
+	trace_span span("container", "draw_borders", 0);
+	m_target->draw_borders(hdc, borders, draw_pos, root);
+}
+
+void litehtml::tracing_container::import_css(tstring& text, const tstring& url, tstring& baseurl)
+{
+	trace_span span("container", "import_css", "url", url.c_str(), true);
+	m_target->import_css(text, url, baseurl);
+}
+
+void litehtml::tracing_container::set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y)
+{
+	trace_span span("container", "set_clip", 0);
+	m_target->set_clip(pos, bdr_radius, valid_x, valid_y);
+}
+
+void litehtml::tracing_container::del_clip()
+{
+	trace_span span("container", "del_clip", 0);
+	m_target->del_clip();
+}
+
+std::shared_ptr<litehtml::element> litehtml::tracing_container::create_element(const tchar_t* tag_name, const string_map& attributes, const std::shared_ptr<document>& doc)
+{
+	trace_span span("container", "create_element", "tag", tag_name, true);
+	return m_target->create_element(tag_name, attributes, doc);
+}
@@ -0,0 +1,100 @@
+#include <assert.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "litehtml.h"
+#include "metrics/container_metrics.h"
+using namespace litehtml;
+
+extern const litehtml::tchar_t master_css[];
+
+// the test binary replaces the global operator new, the allocations are only counted while a
+// phase is measured
+static bool g_count_allocations = false;
+static long g_allocations = 0;
+
+void* operator new(size_t size) {
+  if (g_count_allocations) g_allocations++;
+  void* ptr = malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+template<typename Phase>
+static long CountAllocations(const char* name, Phase phase) {
+  g_allocations = 0;
+  g_count_allocations = true;
+  phase();
+  g_count_allocations = false;
+  printf("%-16s %ld allocations\n", name, g_allocations);
+  return g_allocations;
+}
+
+static const char* AllocationDocument =
+  "<html><head><style>"
+  "b { color: darkred } li { color: rgb(10, 20, 30) }"
+  ".note { color: #336; background: #eee; border: 1px solid red; list-style-image: none }"
+  ".layer { position: relative; z-index: 2 } .under { position: absolute; z-index: -1; top: 0 }"
+  "</style></head><body>"
+  "<h1>Title</h1><p class=note>Some <b>bold</b> text and <a href='#'>a link</a> in a paragraph with enough words to wrap.</p>"
+  "<div class=layer><p>positioned</p><div class=under>under</div></div>"
+  "<ul><li>one</li><li>two</li></ul>"
+  "<ol><li>1</li><li>2</li><li>3</li><li>4</li><li>5</li><li>6</li><li>7</li><li>8</li><li>9</li><li>10</li>"
+  "<li>11</li><li>12</li><li>13</li><li>14</li><li>15</li><li>16</li><li>17</li><li>18</li><li>19</li><li>20</li>"
+  "<li>21</li><li>22</li><li>23</li><li>24</li><li>25</li><li>26</li><li>27</li><li>28</li><li>29</li><li>30</li>"
+  "<li>31</li><li>32</li><li>33</li><li>34</li><li>35</li><li>36</li><li>37</li><li>38</li><li>39</li><li>40</li></ol>"
+  "<table border=1><tr><td>a</td><td>b</td></tr><tr><td colspan=2>c</td></tr></table>"
+  "<div style='overflow:hidden;height:40px'><span style='background:#ff0'>clipped inline text</span></div>"
+  "</body></html>";
+
+static void SteadyStateTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(800, 600);
+  document::ptr doc;
+  CountAllocations("create", [&] { doc = document::createFromUTF8(AllocationDocument, &container, &ctx); });
+  CountAllocations("first render", [&] { doc->render(800); });
+  // the spare boxes and the scratch buffers are filled by the first layouts at each width
+  doc->render(600);
+  doc->render(800);
+  long render = CountAllocations("render", [&] { doc->render(800); });
+  long relayout = CountAllocations("render 600", [&] { doc->render(600); });
+  doc->render(800);
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  long draw = CountAllocations("draw", [&] { doc->draw((uint_ptr)0, 0, 0, nullptr); });
+  assert(render == 0);
+  assert(relayout == 0);
+  assert(draw == 0);
+}
+
+static void DisplayListSteadyStateTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(800, 600);
+  document::ptr doc = document::createFromUTF8(AllocationDocument, &container, &ctx);
+  doc->set_record_display_list(true);
+  doc->render(800);
+  doc->render(800);
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  // a paint renders at the unchanged width and replays the recorded list
+  long paint = CountAllocations("display list", [&] {
+    doc->render(800);
+    doc->draw((uint_ptr)0, 0, 0, nullptr);
+  });
+  assert(paint == 0);
+}
+
+void allocationTest() {
+  SteadyStateTest();
+  DisplayListSteadyStateTest();
+}
@@ -0,0 +1,548 @@
+#include "litehtml.h"
+#include "litehtml/utf8_strings.h"
+#include "metrics/container_metrics.h"
+#include "raster/container_raster.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+extern const litehtml::tchar_t master_css[] =
+{
+#include "master.css.inc"
+,0
+};
+
+using namespace litehtml;
+
+// renders a corpus of HTML files at several widths on a pool of threads, every thread owns its
+// container and documents while the context with the parsed master stylesheet is shared by all,
+// so the run doubles as a stress test of the state shared between documents
+
+struct batch_file
+{
+	std::string	path;
+	std::string	html;
+	bool		loaded;
+};
+
+struct batch_layout
+{
+	int			width;
+	int			height;
+	int			content_width;
+	long long	render_ns;
+};
+
+struct batch_result
+{
+	long long					create_ns;
+	std::vector<batch_layout>	layouts;
+	bool						failed;
+};
+
+struct batch_options
+{
+	std::vector<int>	widths;
+	int					height;
+	int					threads;
+	int					repeat;
+	const char*			raster_dir;
+	const char*			display_list_dir;
+};
+
+// writes the paint calls of a replayed display list as text, one line per call
+class display_list_writer : public container_metrics
+{
+	std::string	m_text;
+public:
+	const std::string& text() const
+	{
+		return m_text;
+	}
+
+	virtual void draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos) override
+	{
+		add_line("text", pos, color);
+		m_text += " \"";
+		m_text += litehtml_to_utf8(text);
+		m_text += "\"\n";
+	}
+	virtual void draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color) override
+	{
+		for(int i = 0; i < count; i++)
+		{
+			draw_text(hdc, texts[i], hFont, color, positions[i]);
+		}
+	}
+	virtual void draw_background(uint_ptr hdc, const background_paint& bg) override
+	{
+		add_line("background", bg.clip_box, bg.color);
+		m_text += "\n";
+	}
+	virtual void draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root) override
+	{
+		add_line("borders", draw_pos, borders.top.color);
+		m_text += "\n";
+	}
+	virtual void draw_list_marker(uint_ptr hdc, const list_marker& marker) override
+	{
+		add_line("list_marker", marker.pos, marker.color);
+		m_text += "\n";
+	}
+	virtual void set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y) override
+	{
+		add_line("set_clip", pos, web_color());
+		m_text += "\n";
+	}
+	virtual void del_clip() override
+	{
+		m_text += "del_clip\n";
+	}
+
+private:
+	void add_line(const char* name, const position& pos, web_color color)
+	{
+		char buf[128];
+		snprintf(buf, sizeof(buf), "%s %d %d %d %d #%02x%02x%02x%02x", name, pos.x, pos.y, pos.width, pos.height, color.red, color.green, color.blue, color.alpha);
+		m_text += buf;
+	}
+};
+
+static long long now_ns()
+{
+	return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool read_file(const std::string& path, std::string& text)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if(!file)
+	{
+		return false;
+	}
+	char buf[4096];
+	size_t len;
+	while((len = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		text.append(buf, len);
+	}
+	fclose(file);
+	return true;
+}
+
+static bool write_file(const std::string& path, const std::string& text)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if(!file)
+	{
+		return false;
+	}
+	bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	return !fclose(file) && written;
+}
+
+static bool is_html(const std::string& name)
+{
+	size_t dot = name.rfind('.');
+	if(dot == std::string::npos)
+	{
+		return false;
+	}
+	std::string ext = name.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext == "html" || ext == "htm";
+}
+
+// adds the HTML files of dir and its subdirectories, false if dir is not a directory
+static bool list_directory(const std::string& dir, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &data);
+	if(find == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	do
+	{
+		std::string name = data.cFileName;
+		if(name == "." || name == "..")
+		{
+			continue;
+		}
+		if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			list_directory(dir + "\\" + name, files);
+		} else if(is_html(name))
+		{
+			files.push_back(dir + "\\" + name);
+		}
+	} while(FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	DIR* d = opendir(dir.c_str());
+	if(!d)
+	{
+		return false;
+	}
+	while(dirent* entry = readdir(d))
+	{
+		std::string name = entry->d_name;
+		if(name == "." || name == "..")
+		{
+			continue;
+		}
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if(stat(path.c_str(), &st))
+		{
+			continue;
+		}
+		if(S_ISDIR(st.st_mode))
+		{
+			list_directory(path, files);
+		} else if(is_html(name))
+		{
+			files.push_back(path);
+		}
+	}
+	closedir(d);
+#endif
+	return true;
+}
+
+// one path per line, relative to the manifest; empty lines and lines starting with # are skipped
+static bool read_manifest(const std::string& manifest, std::vector<std::string>& files)
+{
+	std::string text;
+	if(!read_file(manifest, text))
+	{
+		return false;
+	}
+	size_t slash = manifest.find_last_of("/\\");
+	std::string base = slash == std::string::npos ? std::string() : manifest.substr(0, slash + 1);
+	size_t pos = 0;
+	while(pos < text.size())
+	{
+		size_t end = text.find('\n', pos);
+		if(end == std::string::npos)
+		{
+			end = text.size();
+		}
+		std::string line = text.substr(pos, end - pos);
+		pos = end + 1;
+		while(!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+		{
+			line.pop_back();
+		}
+		if(line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		bool absolute = line[0] == '/' || line[0] == '\\' || (line.size() > 1 && line[1] == ':');
+		files.push_back(absolute ? line : base + line);
+	}
+	return true;
+}
+
+static bool parse_widths(const char* str, std::vector<int>& widths)
+{
+	widths.clear();
+	while(*str)
+	{
+		char* end;
+		long width = strtol(str, &end, 10);
+		if(end == str || width <= 0)
+		{
+			return false;
+		}
+		widths.push_back((int) width);
+		str = *end == ',' ? end + 1 : end;
+	}
+	return !widths.empty();
+}
+
+static std::string json_string(const std::string& str)
+{
+	std::string ret = "\"";
+	for(char ch : str)
+	{
+		if(ch == '"' || ch == '\\')
+		{
+			ret += '\\';
+			ret += ch;
+		} else if((unsigned char) ch < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", ch);
+			ret += buf;
+		} else
+		{
+			ret += ch;
+		}
+	}
+	return ret + "\"";
+}
+
+// file name for the outputs of a file, the index keeps files with the same name apart
+static std::string output_name(const char* dir, size_t index, const std::string& path, int width, const char* ext)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	size_t dot = name.rfind('.');
+	if(dot != std::string::npos)
+	{
+		name.erase(dot);
+	}
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%04d_", (int) index);
+	return std::string(dir) + "/" + buf + name + "_" + std::to_string(width) + ext;
+}
+
+static void render_file(const batch_file& file, size_t index, bool write_outputs, const batch_options& options, context* ctx, container_raster& container, batch_result& result)
+{
+	container.set_client_size(options.widths[0], options.height);
+	long long start = now_ns();
+	document::ptr doc = document::createFromUTF8(file.html.c_str(), &container, ctx);
+	result.create_ns = now_ns() - start;
+	if(write_outputs && options.display_list_dir)
+	{
+		doc->set_record_display_list(true);
+	}
+
+	result.layouts.resize(options.widths.size());
+	for(size_t w = 0; w < options.widths.size(); w++)
+	{
+		batch_layout& layout = result.layouts[w];
+		layout.width = options.widths[w];
+		container.set_client_size(layout.width, options.height);
+		start = now_ns();
+		doc->media_changed();
+		doc->render(layout.width);
+		layout.render_ns		= now_ns() - start;
+		layout.height			= doc->height();
+		layout.content_width	= doc->width();
+
+		if(!write_outputs)
+		{
+			continue;
+		}
+		if(options.display_list_dir)
+		{
+			// the list is recorded by the first draw after a layout
+			if(!doc->get_display_list().is_valid())
+			{
+				doc->draw((uint_ptr) 0, 0, 0, nullptr);
+			}
+			display_list_writer writer;
+			doc->get_display_list().replay(&writer, 0, 0, 0, nullptr);
+			if(!write_file(output_name(options.display_list_dir, index, file.path, layout.width, ".txt"), writer.text()))
+			{
+				result.failed = true;
+			}
+		}
+		if(options.raster_dir)
+		{
+			container.resize(layout.width, std::max(layout.height, 1));
+			position clip(0, 0, container.width(), container.height());
+			doc->draw((uint_ptr) 0, 0, 0, &clip);
+			if(!container.write_png(output_name(options.raster_dir, index, file.path, layout.width, ".png").c_str()))
+			{
+				result.failed = true;
+			}
+			container.resize(0, 0);
+		}
+	}
+}
+
+static int usage()
+{
+	fprintf(stderr,
+		"usage: litehtml_batch [options] (file.html | directory)...\n"
+		"  --manifest FILE      read the files from FILE, one per line\n"
+		"  --widths W,W,...     layout widths, 320,800,1280 by default\n"
+		"  --height N           viewport height for media queries, 600 by default\n"
+		"  --threads N          worker threads, the number of cores by default\n"
+		"  --repeat N           render every file N times, 1 by default\n"
+		"  --raster DIR         paint the first render of every width into DIR as PNG\n"
+		"  --display-list DIR   write the paint calls of every width into DIR as text\n");
+	return 2;
+}
+
+int main(int argc, char **argv)
+{
+	batch_options options;
+	options.widths				= { 320, 800, 1280 };
+	options.height				= 600;
+	options.threads				= (int) std::thread::hardware_concurrency();
+	options.repeat				= 1;
+	options.raster_dir			= 0;
+	options.display_list_dir	= 0;
+
+	std::vector<std::string> paths;
+	for(int i = 1; i < argc; i++)
+	{
+		bool has_value = i + 1 < argc;
+		if(!strcmp(argv[i], "--manifest") && has_value)
+		{
+			if(!read_manifest(argv[++i], paths))
+			{
+				fprintf(stderr, "can't read %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if(!strcmp(argv[i], "--widths") && has_value)			{ if(!parse_widths(argv[++i], options.widths)) return usage(); }
+		else if(!strcmp(argv[i], "--height") && has_value)			options.height				= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--threads") && has_value)			options.threads				= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--repeat") && has_value)			options.repeat				= atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--raster") && has_value)			options.raster_dir			= argv[++i];
+		else if(!strcmp(argv[i], "--display-list") && has_value)	options.display_list_dir	= argv[++i];
+		else if(argv[i][0] == '-')									return usage();
+		else
+		{
+			// the files of a directory are rendered in name order, so the indexes are stable
+			size_t first = paths.size();
+			if(list_directory(argv[i], paths))
+			{
+				std::sort(paths.begin() + first, paths.end());
+			} else
+			{
+				paths.push_back(argv[i]);
+			}
+		}
+	}
+	if(paths.empty())
+	{
+		return usage();
+	}
+	options.threads	= std::max(options.threads, 1);
+	options.repeat	= std::max(options.repeat, 1);
+
+	std::vector<batch_file> files(paths.size());
+	size_t bytes = 0;
+	int errors = 0;
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		files[i].path	= paths[i];
+		files[i].loaded	= read_file(paths[i], files[i].html);
+		if(!files[i].loaded)
+		{
+			fprintf(stderr, "can't read %s\n", paths[i].c_str());
+			errors++;
+		}
+		bytes += files[i].html.size();
+	}
+
+	// the master stylesheet is parsed once for all threads
+	context ctx;
+	long long start = now_ns();
+	ctx.load_master_stylesheet(master_css);
+	long long master_css_ns = now_ns() - start;
+
+	// a job is one file in one repetition, the first repetition of a file writes its outputs
+	size_t jobs = files.size() * options.repeat;
+	std::vector<batch_result> results(jobs);
+	std::atomic<size_t> next_job(0);
+	auto worker = [&]()
+	{
+		container_raster container(0, 0);
+		container.set_default_image_size(100, 50);
+		size_t job;
+		while((job = next_job++) < jobs)
+		{
+			size_t index = job % files.size();
+			results[job].failed = false;
+			if(files[index].loaded)
+			{
+				render_file(files[index], index, job < files.size(), options, &ctx, container, results[job]);
+			}
+		}
+	};
+	start = now_ns();
+	std::vector<std::thread> threads;
+	for(int i = 1; i < options.threads; i++)
+	{
+		threads.push_back(std::thread(worker));
+	}
+	worker();
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+	long long wall_ns = now_ns() - start;
+
+	// every repetition must lay out the same boxes as the first one, whichever thread ran it
+	int mismatches = 0;
+	long long render_ns = 0;
+	for(size_t job = 0; job < jobs; job++)
+	{
+		const batch_result& res = results[job];
+		const batch_result& first = results[job % files.size()];
+		if(res.failed)
+		{
+			errors++;
+		}
+		for(size_t w = 0; w < res.layouts.size(); w++)
+		{
+			render_ns += res.layouts[w].render_ns;
+			if(res.layouts[w].height != first.layouts[w].height || res.layouts[w].content_width != first.layouts[w].content_width)
+			{
+				fprintf(stderr, "%s: layout at %d differs between repetitions\n", files[job % files.size()].path.c_str(), res.layouts[w].width);
+				mismatches++;
+			}
+		}
+	}
+
+	// the fastest repetition is reported for every file
+	printf("{\n  \"threads\": %d,\n  \"repeat\": %d,\n  \"master_css_ns\": %lld,\n  \"files\": [\n", options.threads, options.repeat, master_css_ns);
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		printf("    { \"file\": %s, \"bytes\": %d", json_string(files[i].path).c_str(), (int) files[i].html.size());
+		if(files[i].loaded)
+		{
+			long long create_ns = results[i].create_ns;
+			for(size_t job = i; job < jobs; job += files.size())
+			{
+				create_ns = std::min(create_ns, results[job].create_ns);
+			}
+			printf(", \"create_ns\": %lld, \"layouts\": [", create_ns);
+			for(size_t w = 0; w < results[i].layouts.size(); w++)
+			{
+				long long ns = results[i].layouts[w].render_ns;
+				for(size_t job = i; job < jobs; job += files.size())
+				{
+					ns = std::min(ns, results[job].layouts[w].render_ns);
+				}
+				printf("%s{ \"width\": %d, \"height\": %d, \"content_width\": %d, \"render_ns\": %lld }", w ? ", " : " ", results[i].layouts[w].width, results[i].layouts[w].height, results[i].layouts[w].content_width, ns);
+			}
+			printf(" ]");
+		} else
+		{
+			printf(", \"error\": \"can't read\"");
+		}
+		printf(" }%s\n", i + 1 < files.size() ? "," : "");
+	}
+	double seconds = wall_ns / 1e9;
+	size_t documents = 0;
+	for(const auto& file : files)
+	{
+		documents += file.loaded ? options.repeat : 0;
+	}
+	printf("  ],\n  \"documents\": %d,\n  \"layouts\": %d,\n  \"errors\": %d,\n  \"mismatches\": %d,\n  \"wall_ns\": %lld,\n  \"render_ns\": %lld,\n",
+		(int) documents, (int) (documents * options.widths.size()), errors, mismatches, wall_ns, render_ns);
+	printf("  \"documents_per_s\": %.1f,\n  \"layouts_per_s\": %.1f,\n  \"mb_per_s\": %.2f\n}\n",
+		seconds > 0 ? documents / seconds : 0.0, seconds > 0 ? documents * options.widths.size() / seconds : 0.0, seconds > 0 ? bytes * options.repeat / 1e6 / seconds : 0.0);
+	return errors || mismatches ? 1 : 0;
+}
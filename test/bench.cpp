@@ -0,0 +1,251 @@
+#include "litehtml.h"
+#include "metrics/container_metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+extern const litehtml::tchar_t master_css[] =
+{
+#include "master.css.inc"
+,0
+};
+
+using namespace litehtml;
+
+struct corpus_doc
+{
+	std::string	name;
+	std::string	html;
+};
+
+static std::string prose_doc()
+{
+	static const char* words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do", "eiusmod", "tempor" };
+	std::string html = "<html><body>";
+	for(int p = 0; p < 400; p++)
+	{
+		html += "<p>";
+		for(int w = 0; w < 80; w++)
+		{
+			if(w % 17 == 5)			html += "<b>";
+			html += words[(p * 7 + w * 3) % 12];
+			if(w % 17 == 5)			html += "</b>";
+			html += w % 11 == 10 ? ". " : " ";
+		}
+		html += "</p>";
+	}
+	return html + "</body></html>";
+}
+
+static std::string nesting_doc()
+{
+	std::string html = "<html><body>";
+	for(int n = 0; n < 20; n++)
+	{
+		for(int d = 0; d < 100; d++)
+		{
+			html += d % 2 ? "<div style='padding-left:1px'>" : "<div>";
+		}
+		html += "deep text";
+		for(int d = 0; d < 100; d++)
+		{
+			html += "</div>";
+		}
+	}
+	return html + "</body></html>";
+}
+
+static std::string table_doc()
+{
+	std::string html = "<html><body><table border=1>";
+	for(int r = 0; r < 1000; r++)
+	{
+		html += "<tr>";
+		for(int c = 0; c < 8; c++)
+		{
+			html += "<td>cell " + std::to_string(r) + "," + std::to_string(c) + "</td>";
+		}
+		html += "</tr>";
+	}
+	return html + "</table></body></html>";
+}
+
+static std::string float_doc()
+{
+	std::string html = "<html><body>";
+	// float placement is far from linear in the number of floats, a bigger grid takes minutes
+	for(int i = 0; i < 500; i++)
+	{
+		html += "<div style='float:left;width:" + std::to_string(80 + (i % 5) * 20) + "px;height:" + std::to_string(40 + (i % 3) * 15) + "px;margin:4px'>item " + std::to_string(i) + "</div>";
+	}
+	return html + "</body></html>";
+}
+
+static std::string bootstrap_doc()
+{
+	std::string html = "<html><head><style>";
+	static const char* parts[] = { "container", "row", "col", "btn", "nav", "card", "alert", "badge", "list", "form" };
+	for(int i = 0; i < 10; i++)
+	{
+		for(int j = 0; j < 30; j++)
+		{
+			std::string cls = std::string(parts[i]) + "-" + std::to_string(j);
+			html += "." + cls + "{margin:" + std::to_string(j % 4) + "px;padding:2px}";
+			html += "." + std::string(parts[i]) + " ." + cls + ":hover{color:#" + (j % 2 ? "f00" : "00f") + "}";
+			html += "div > ." + cls + " + ." + cls + "{border:1px solid #ccc}";
+		}
+	}
+	html += "</style></head><body>";
+	for(int i = 0; i < 600; i++)
+	{
+		std::string cls = std::string(parts[i % 10]) + "-" + std::to_string(i % 30);
+		html += "<div class='" + std::string(parts[(i + 1) % 10]) + "'><div class='" + cls + "'>text <a href='#' class='" + cls + "'>link</a></div><div class='" + cls + "'>more</div></div>";
+	}
+	return html + "</body></html>";
+}
+
+static std::string cjk_doc()
+{
+	std::string html = "<html><body>";
+	for(int p = 0; p < 300; p++)
+	{
+		html += "<p>";
+		for(int w = 0; w < 60; w++)
+		{
+			html += (w + p) % 3 ? "\xE6\xBC\xA2\xE5\xAD\x97\xE3\x81\x8B\xE3\x81\xAA" : "\xED\x95\x9C\xEA\xB8\x80 ";
+		}
+		html += "</p>";
+	}
+	return html + "</body></html>";
+}
+
+static long long now_ns()
+{
+	return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int count_elements(const element::ptr& el)
+{
+	int count = 1;
+	for(size_t i = 0; i < el->get_children_count(); i++)
+	{
+		count += count_elements(el->get_child((int) i));
+	}
+	return count;
+}
+
+struct phase
+{
+	const char*	name;
+	long long	ns;
+};
+
+static void print_phase(const phase& ph, int elements, bool last)
+{
+	printf("        \"%s\": { \"ns\": %lld, \"ns_per_element\": %.1f }%s\n", ph.name, ph.ns, elements ? (double) ph.ns / elements : 0.0, last ? "" : ",");
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = argc > 1 ? atoi(argv[1]) : 5;
+	if(iterations < 1)
+	{
+		iterations = 1;
+	}
+
+	std::vector<corpus_doc> corpus = {
+		{ "prose",		prose_doc() },
+		{ "nesting",	nesting_doc() },
+		{ "table",		table_doc() },
+		{ "floats",		float_doc() },
+		{ "bootstrap",	bootstrap_doc() },
+		{ "cjk",		cjk_doc() },
+	};
+	static const int widths[] = { 320, 800, 1280 };
+
+	// the fastest of the iterations is reported for every phase
+	long long master_css_ns = 0;
+	printf("{\n  \"iterations\": %d,\n  \"documents\": [\n", iterations);
+	for(size_t d = 0; d < corpus.size(); d++)
+	{
+		std::vector<phase> phases = {
+			{ "parse_html", 0 }, { "parse_css", 0 }, { "apply_stylesheet", 0 }, { "parse_attributes", 0 }, { "parse_styles", 0 }, { "fix_tables_layout", 0 }, { "init", 0 },
+			{ "render_320", 0 }, { "render_800", 0 }, { "render_1280", 0 }, { "draw", 0 }, { "hit_test", 0 },
+		};
+		int elements = 0;
+		int draw_calls = 0;
+		for(int it = 0; it < iterations; it++)
+		{
+			// synthetic glyph advances and a fixed viewport, so every run lays out the same boxes
+			container_metrics container;
+			container.set_client_size(1024, 768);
+			container.set_default_image_size(100, 50);
+			context ctx;
+			long long start = now_ns();
+			ctx.load_master_stylesheet(master_css);
+			long long ns = now_ns() - start;
+			if(!master_css_ns || ns < master_css_ns)
+			{
+				master_css_ns = ns;
+			}
+
+			document::ptr doc = document::createFromUTF8(corpus[d].html.c_str(), &container, &ctx);
+			const document_timings& timings = doc->get_timings();
+			std::vector<long long> times = { timings.parse_html, timings.parse_css, timings.apply_stylesheet, timings.parse_attributes, timings.parse_styles, timings.fix_tables, timings.init };
+
+			for(int w = 0; w < 3; w++)
+			{
+				start = now_ns();
+				doc->render(widths[w]);
+				times.push_back(now_ns() - start);
+			}
+
+			doc->render(800);
+			container.reset_counts();
+			start = now_ns();
+			doc->draw((uint_ptr) 0, 0, 0, nullptr);
+			times.push_back(now_ns() - start);
+			draw_calls = container.counts().total();
+
+			position::vector redraw_boxes;
+			start = now_ns();
+			for(int y = 0; y < doc->height(); y += std::max(1, doc->height() / 20))
+			{
+				for(int x = 0; x < 800; x += 40)
+				{
+					doc->on_mouse_over(x, y, x, y, redraw_boxes);
+				}
+			}
+			times.push_back(now_ns() - start);
+
+			for(size_t p = 0; p < phases.size(); p++)
+			{
+				if(!it || times[p] < phases[p].ns)
+				{
+					phases[p].ns = times[p];
+				}
+			}
+			elements = count_elements(doc->root());
+		}
+
+		double bytes = (double) corpus[d].html.size();
+		long long create_ns = 0;
+		for(size_t p = 0; p < 7; p++)
+		{
+			create_ns += phases[p].ns;
+		}
+		printf("    {\n      \"name\": \"%s\",\n      \"bytes\": %d,\n      \"elements\": %d,\n      \"draw_calls\": %d,\n", corpus[d].name.c_str(), (int) corpus[d].html.size(), elements, draw_calls);
+		printf("      \"parse_html_mb_per_s\": %.2f,\n      \"create_mb_per_s\": %.2f,\n      \"phases\": {\n",
+			phases[0].ns ? bytes / 1048576.0 / (phases[0].ns / 1e9) : 0.0, create_ns ? bytes / 1048576.0 / (create_ns / 1e9) : 0.0);
+		for(size_t p = 0; p < phases.size(); p++)
+		{
+			print_phase(phases[p], elements, p + 1 == phases.size());
+		}
+		printf("      }\n    }%s\n", d + 1 == corpus.size() ? "" : ",");
+	}
+	printf("  ],\n  \"master_css_ns\": %lld\n}\n", master_css_ns);
+	return 0;
+}
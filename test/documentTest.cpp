@@ -1,8 +1,74 @@
 #include <assert.h>
 #include "litehtml.h"
+#include "litehtml/utf8_strings.h"
+#include "litehtml/el_text.h"
 #include "test/container_test.h"
+#include "metrics/container_metrics.h"
+#include "raster/container_raster.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
 using namespace litehtml;
 
+// keeps every paint call as a line of text, the pieces of a text run are logged one by one
+class container_log : public container_metrics {
+ public:
+  std::vector<std::string> log;
+  std::vector<position> boxes;
+  std::vector<int> runs;
+
+  virtual void draw_text(uint_ptr hdc, const tchar_t* text, uint_ptr hFont, web_color color, const position& pos) override {
+    add("text", pos, color, text);
+  }
+  virtual void draw_text_run(uint_ptr hdc, const tchar_t* const* texts, const position* positions, int count, uint_ptr hFont, web_color color) override {
+    runs.push_back(count);
+    for (int i = 0; i < count; i++) add("text", positions[i], color, texts[i]);
+  }
+  virtual void draw_background(uint_ptr hdc, const background_paint& bg) override {
+    add("background", bg.clip_box, bg.color);
+  }
+  virtual void draw_borders(uint_ptr hdc, const borders& borders, const position& draw_pos, bool root) override {
+    add("borders", draw_pos, borders.top.color);
+  }
+  virtual void draw_list_marker(uint_ptr hdc, const list_marker& marker) override {
+    add("marker", marker.pos, marker.color);
+  }
+  virtual void set_clip(const position& pos, const border_radiuses& bdr_radius, bool valid_x, bool valid_y) override {
+    add("clip", pos, web_color());
+  }
+  virtual void del_clip() override {
+    log.push_back("del_clip");
+    boxes.push_back(position());
+  }
+  void clear() {
+    log.clear();
+    boxes.clear();
+    runs.clear();
+  }
+  // the paint calls that can reach the pixels inside clip
+  std::vector<std::string> visible(const position& clip) const {
+    std::vector<std::string> ret;
+    for (size_t i = 0; i < log.size(); i++)
+      if (log[i].compare(0, 4, "clip") && log[i] != "del_clip" && boxes[i].does_intersect(&clip)) ret.push_back(log[i]);
+    return ret;
+  }
+  int count(const char* prefix) const {
+    int ret = 0;
+    for (const auto& line : log)
+      if (!line.compare(0, strlen(prefix), prefix)) ret++;
+    return ret;
+  }
+
+ private:
+  void add(const char* name, const position& pos, web_color color, const tchar_t* text = _t("")) {
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s %d %d %d %d %02x%02x%02x ", name, pos.x, pos.y, pos.width, pos.height, color.red, color.green, color.blue);
+    log.push_back(buf + std::string(litehtml_to_utf8(text)));
+    boxes.push_back(pos);
+  }
+};
+
 static void AddFontTest() {
   container_test container;
   litehtml::document::ptr doc = std::make_shared<litehtml::document>(&container, nullptr);
@@ -90,6 +156,670 @@ static void DeviceChangeTest() {
   doc->lang_changed();
 }
 
+extern const litehtml::tchar_t master_css[];
+
+static void AppendTextTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(400, 300);
+  litehtml::document::ptr doc = document::createFromString(_t("<html><body><p>Hello</p></body></html>"), &container, &ctx);
+  doc->render(400, render_all);
+  // a text parsed on its own is not measured by its parent, so it measures itself
+  element::ptr p = doc->root()->select_one(_t("p"));
+  element::ptr text = std::make_shared<el_text>(_t("world"), doc);
+  p->appendChild(text);
+  text->parse_styles();
+  size sz;
+  text->get_content_size(sz, 0);
+  assert(sz.width == container.text_width(_t("world"), p->get_font()));
+  doc->render(400, render_all);
+  assert(text->get_placement().width == sz.width);
+  assert(text->get_placement().x > p->get_placement().x);
+}
+
+static void LazyLayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log full_container;
+  full_container.set_client_size(300, 200);
+  container_log lazy_container;
+  lazy_container.set_client_size(300, 200);
+  tstring html = _t("<html><body>");
+  for (int i = 0; i < 40; i++) {
+    html += _t("<p>Paragraph with a few words of <b>bold text</b> to wrap</p>");
+    html += _t("<div style='position: relative; margin: 10px 0; padding: 5px; border: 1px solid red'><p>Nested</p><ul><li>Item</li></ul></div>");
+    html += _t("Loose <i>inline</i> words");
+  }
+  html += _t("</body></html>");
+  litehtml::document::ptr full = document::createFromString(html.c_str(), &full_container, &ctx);
+  full->render(300, render_all);
+  litehtml::document::ptr lazy = document::createFromString(html.c_str(), &lazy_container, &ctx);
+  lazy->set_lazy_layout(true);
+  lazy->render(300, render_all);
+  // the estimates are built from the cached content widths, without a layout of the blocks
+  assert(lazy->height() > full->height() * 3 / 4 && lazy->height() < full->height() * 5 / 4);
+
+  // the first screen is laid out right away
+  position screen(0, 0, 300, 200);
+  full->draw((uint_ptr)0, 0, 0, &screen);
+  lazy->draw((uint_ptr)0, 0, 0, &screen);
+  // only the root box differs, it covers the estimated height
+  std::vector<std::string> lazy_screen = lazy_container.visible(screen);
+  std::vector<std::string> full_screen = full_container.visible(screen);
+  assert(lazy_screen[0] != full_screen[0]);
+  assert(std::vector<std::string>(lazy_screen.begin() + 1, lazy_screen.end()) == std::vector<std::string>(full_screen.begin() + 1, full_screen.end()));
+
+  // realizing the rest updates only the changed paths, the result matches a full layout
+  lazy->draw((uint_ptr)0, 0, 0, nullptr);
+  assert(lazy->height() == full->height());
+  assert(lazy->width() == full->width());
+  position middle(0, full->height() / 2, 300, 200);
+  full_container.clear();
+  lazy_container.clear();
+  full->draw((uint_ptr)0, 0, 0, &middle);
+  lazy->draw((uint_ptr)0, 0, 0, &middle);
+  assert(lazy_container.log == full_container.log);
+}
+
+static tstring LazySections(int count, bool changed) {
+  tstring html = _t("<html><body>");
+  for (int i = 0; i < count; i++) {
+    html += _t("<div class=sec><div class=inner>");
+    if (!changed || i != count - 2) html += _t("<p>First paragraph of the section with words</p>");
+    html += _t("<p>Second paragraph</p>");
+    if (changed && i == count - 1) html += _t("<p>Added</p>");
+    html += _t("</div></div>");
+  }
+  return html + _t("</body></html>");
+}
+
+static void LazyEstimateTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(300, 100);
+  litehtml::document::ptr doc = document::createFromString(LazySections(20, false).c_str(), &container, &ctx);
+  doc->set_lazy_layout(true);
+  doc->render(300, render_all);
+  // the changes below the deferred sections reach their estimates through the ancestors
+  elements_vector inners = doc->root()->select_all(_t(".inner"));
+  string_map attrs;
+  element::ptr added = doc->create_element(_t("p"), attrs);
+  added->appendChild(std::make_shared<el_text>(_t("Added"), doc));
+  inners.back()->appendChild(added);
+  added->apply_stylesheet(ctx.master_css());
+  added->parse_styles();
+  inners[inners.size() - 2]->removeChild(inners[inners.size() - 2]->get_child(0));
+  doc->render(300, render_all);
+  litehtml::document::ptr fresh = document::createFromString(LazySections(20, true).c_str(), &container, &ctx);
+  fresh->set_lazy_layout(true);
+  fresh->render(300, render_all);
+  assert(doc->height() == fresh->height());
+}
+
+static void ParallelLayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log serial_container;
+  serial_container.set_client_size(400, 300);
+  container_log parallel_container;
+  parallel_container.set_client_size(400, 300);
+  tstring html = _t("<html><body><div style='position:relative;height:80px'>");
+  for (int i = 0; i < 10; i++) {
+    html += _t("<div style='position:absolute;top:") + tstring(1, (tchar_t)(_t('0') + i)) + _t("0px;left:") + tstring(1, (tchar_t)(_t('0') + i)) + _t("0%;width:30%'>Positioned text that wraps <span style='position:relative;top:3px'>shifted</span></div>");
+  }
+  html += _t("</div><div style='float:right;width:120px'>Floating words beside the table</div><table>");
+  for (int i = 0; i < 20; i++) {
+    html += _t("<tr><td>Cell with several words</td><td colspan=2>Wide cell text</td><td><table><tr><td>Inner</td><td style='width:40%'>Nested words</td></tr></table></td></tr>");
+  }
+  html += _t("</table></body></html>");
+  litehtml::document::ptr serial = document::createFromString(html.c_str(), &serial_container, &ctx);
+  serial->render(400, render_all);
+  litehtml::document::ptr parallel = document::createFromString(html.c_str(), &parallel_container, &ctx);
+  parallel->set_executor(std::make_shared<thread_pool_executor>(4));
+  parallel->render(400, render_all);
+  assert(parallel->height() == serial->height());
+  assert(parallel->width() == serial->width());
+  // every box and text piece is painted at the same place
+  serial->draw((uint_ptr)0, 0, 0, nullptr);
+  parallel->draw((uint_ptr)0, 0, 0, nullptr);
+  assert(serial_container.count("text") > 100);
+  assert(parallel_container.log == serial_container.log);
+}
+
+static void FixedTableLayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_test container;
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<table style='table-layout:fixed;width:400px;border-spacing:0'>"
+         "<tr><td style='width:100px;padding:0;border:0'>A</td><td style='padding:0;border:0'>B</td><td style='padding:0;border:0'>C</td></tr>"
+         "<tr><td>D</td><td style='width:300px'>E</td><td>F</td></tr></table>"),
+      &container, &ctx);
+  doc->render(800, render_all);
+  element::ptr row = doc->root()->select_one(_t("tr"));
+  assert(row->get_child(0)->get_placement().width == 100);
+  assert(row->get_child(1)->get_placement().width == 150);
+  assert(row->get_child(2)->get_placement().width == 150);
+
+  // the padding and borders of a content-box cell come on top of its css width
+  doc = document::createFromString(
+      _t("<table style='table-layout:fixed;width:400px;border-spacing:0'>"
+         "<tr><td style='width:100px;padding:5px;border:2px solid'>A</td><td style='width:100px;padding:5px;box-sizing:border-box'>B</td><td>C</td></tr></table>"),
+      &container, &ctx);
+  doc->render(800, render_all);
+  row = doc->root()->select_one(_t("tr"));
+  auto border_box_width = [](const element::ptr& el) {
+    return el->get_placement().width + el->get_paddings().width() + el->get_borders().width();
+  };
+  assert(row->get_child(0)->get_placement().width == 100);
+  assert(border_box_width(row->get_child(0)) == 114);
+  assert(border_box_width(row->get_child(1)) == 100);
+  assert(border_box_width(row->get_child(2)) == 186);
+}
+
+static void FixedTableRelayoutTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(800, 600);
+  // a style change at the same width lays the fixed layout cells out again, as in the auto layout
+  for (int fixed = 0; fixed < 2; fixed++) {
+    litehtml::document::ptr doc = document::createFromString(
+        fixed ? _t("<style>td:hover { font-size: 40px }</style><table style='table-layout:fixed;width:200px'><tr><td>A</td></tr></table>")
+              : _t("<style>td:hover { font-size: 40px }</style><table style='width:200px'><tr><td>A</td></tr></table>"),
+        &container, &ctx);
+    doc->render(800, render_all);
+    element::ptr table = doc->root()->select_one(_t("table"));
+    int height = table->get_placement().height;
+    position cell = doc->root()->select_one(_t("td"))->get_placement();
+    position::vector redraw_boxes;
+    doc->on_mouse_over(cell.x + 1, cell.y + 1, cell.x + 1, cell.y + 1, redraw_boxes);
+    doc->render(800, render_all);
+    assert(table->get_placement().height > height);
+  }
+}
+
+static void TableCaptionTreeTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_test container;
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<div id=t style='display:table'><div style='display:table-caption'>Cap</div>"
+         "<div style='display:table-column-group'><div style='display:table-column'></div></div><div style='display:table-column'></div>"
+         "<div style='display:table-row'><div style='display:table-cell'>A</div></div></div>"
+         "<div id=c style='display:table-caption'>Loose</div>"),
+      &container, &ctx);
+  // caption and columns stay direct children of the table, only the row gets an anonymous row group
+  element::ptr table = doc->root()->select_one(_t("#t"));
+  assert(table->get_children_count() == 4);
+  assert(table->get_child(0)->get_display() == display_table_caption);
+  assert(table->get_child(1)->get_display() == display_table_column_group);
+  assert(table->get_child(1)->get_child(0)->get_display() == display_table_column);
+  assert(table->get_child(2)->get_display() == display_table_column);
+  element::ptr group = table->get_child(3);
+  assert(group->get_display() == display_table_row_group);
+  assert(group->get_children_count() == 1 && group->get_child(0)->get_display() == display_table_row);
+  // a caption outside a table gets an anonymous table as its parent
+  element::ptr caption = doc->root()->select_one(_t("#c"));
+  assert(caption->parent()->get_display() == display_table);
+  assert(caption->parent()->parent()->get_display() != display_table_cell);
+  doc->render(800, render_all);
+}
+
+static void TableHitTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(800, 600);
+  tstring html = _t("<table>");
+  for (int i = 0; i < 100; i++) {
+    html += _t("<tr><td>Cell</td><td>Cell</td></tr>");
+  }
+  html += _t("</table>");
+  litehtml::document::ptr doc = document::createFromString(html.c_str(), &container, &ctx);
+  doc->render(800, render_all);
+  element::ptr cell = doc->root()->select_all(_t("td"))[151];
+  position pos = cell->get_placement();
+  element::ptr hit = doc->root()->get_element_by_point(pos.x + 1, pos.y + 1, pos.x + 1, pos.y + 1);
+  assert(hit == cell || hit->parent() == cell);
+  // only the row of the cell is painted
+  position clip(0, pos.y, 800, pos.height);
+  doc->draw((uint_ptr)0, 0, 0, &clip);
+  assert(container.count("text") == 2);
+  for (size_t i = 0; i < container.log.size(); i++) {
+    if (!container.log[i].compare(0, 4, "text")) assert(container.boxes[i].does_intersect(&clip));
+  }
+}
+
+static void TableSpacingClipTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(400, 600);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<table style='border-spacing: 10px'><tr><td rowspan=2 style='border: 1px solid red'>Span</td><td>A</td></tr><tr><td>B</td></tr></table>"),
+      &container, &ctx);
+  doc->render(400, render_all);
+  position a = doc->root()->select_one(_t("td:nth-child(2)"))->get_placement();
+  // a thin strip in the spacing below the first row still crosses the spanning cell
+  position clip(0, a.bottom() + 4, 400, 2);
+  doc->draw((uint_ptr)0, 0, 0, &clip);
+  int span_borders = 0;
+  for (const auto& line : container.log) {
+    if (!line.compare(0, 7, "borders") && line.find("ff0000") != std::string::npos) span_borders++;
+  }
+  assert(span_borders == 1);
+  // the text of the spanning cell is centered into the spacing, the other cells are not painted
+  assert(container.count("text") == 1);
+  assert(container.log.back().find("Span") != std::string::npos);
+}
+
+static void DisplayListTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(100, 600);
+  const tchar_t* html = _t("<html><head><style>li:hover { color: red }</style></head><body><ul><li>Item</li></ul><div style='overflow:hidden;height:10px'><p>A</p><p>B</p></div><p>Some text</p>"
+                           "<div style='position:relative;z-index:1;border:1px solid red'>over</div></body></html>");
+  litehtml::document::ptr direct = document::createFromString(html, &container, &ctx);
+  direct->render(100, render_all);
+  litehtml::document::ptr doc = document::createFromString(html, &container, &ctx);
+  doc->set_record_display_list(true);
+  doc->render(100, render_all);
+  // render leaves the recording to the first draw
+  assert(!doc->get_display_list().is_valid());
+
+  // the whole page replays the calls of a direct draw, a partial clip the calls that reach it
+  container.clear();
+  direct->draw((uint_ptr)0, 0, -10, nullptr);
+  std::vector<std::string> expected = container.log;
+  container.clear();
+  doc->draw((uint_ptr)0, 0, -10, nullptr);
+  assert(doc->get_display_list().is_valid());
+  assert(container.log == expected);
+  position clips[] = { position(0, 20, 100, 20), position(0, 60, 100, 15), position(0, 200, 100, 20) };
+  for (const position& clip : clips) {
+    container.clear();
+    direct->draw((uint_ptr)0, 0, -10, &clip);
+    expected = container.visible(clip);
+    container.clear();
+    doc->draw((uint_ptr)0, 0, -10, &clip);
+    assert(container.visible(clip) == expected);
+  }
+
+  // a render at the same width keeps the list, a new width or a style change drops it
+  doc->render(100, render_all);
+  assert(doc->get_display_list().is_valid());
+  doc->render(80, render_all);
+  assert(!doc->get_display_list().is_valid());
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  assert(doc->get_display_list().is_valid());
+  position::vector redraw_boxes;
+  position item = doc->root()->select_one(_t("li"))->get_placement();
+  assert(doc->on_mouse_over(item.x + 1, item.y + 1, item.x + 1, item.y + 1, redraw_boxes));
+  assert(!doc->get_display_list().is_valid());
+  doc->render(80, render_all);
+  container.clear();
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  bool hovered = false;
+  for (const auto& line : container.log)
+    if (line.find("ff0000 Item") != std::string::npos) hovered = true;
+  assert(hovered);
+}
+
+static void TextRunTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(400, 600);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><body><p>one two <span style='color:red'>three four</span> five</p><p>six</p></body></html>"),
+      &container, &ctx);
+  doc->render(400, render_all);
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  std::vector<std::string> expected = container.log;
+  assert(container.runs.empty());
+  // words with the same font, color and top become one run, the red words and the next line start new ones
+  doc->set_record_display_list(true);
+  container.clear();
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  std::vector<int> runs = { 2, 2 };
+  assert(container.runs == runs);
+  assert(container.log == expected);
+  assert(container.count("text") == 6);
+}
+
+static void InkCullingTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(200, 600);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><body style='margin:0'><p style='margin:0;height:40px'>top</p>"
+         "<div style='height:40px;overflow:hidden'><p style='margin:0'>in</p><p style='margin:60px 0 0'>cut</p><p style='position:relative'>cut</p></div>"
+         "<div style='height:10px;border:1px solid red'><p style='margin:30px 0 0'>spill</p></div>"
+         "<p style='margin:80px 0 0'>bottom</p></body></html>"),
+      &container, &ctx);
+  doc->render(200, render_all);
+  // the paragraphs past the bottom of the overflow box are not drawn even without a clip
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  assert(container.count("text") == 4);
+  for (const auto& line : container.log) assert(line.find("cut") == std::string::npos);
+  // a clip around the paragraph that overflows its parent draws it, but not the parent or the other paragraphs
+  position clip = doc->root()->select_one(_t("div + div p"))->get_placement();
+  container.clear();
+  doc->draw((uint_ptr)0, 0, 0, &clip);
+  assert(container.count("text") == 1);
+  assert(container.log.back().find("spill") != std::string::npos);
+  assert(container.visible(clip).size() == container.log.size());
+}
+
+// child indices from the root down to el, the same in two documents from the same html
+static std::vector<int> ElementPath(element::ptr el) {
+  std::vector<int> path;
+  for (element::ptr parent = el ? el->parent() : nullptr; parent; el = parent, parent = parent->parent()) {
+    int i = 0;
+    while (parent->get_child(i) != el) i++;
+    path.insert(path.begin(), i);
+  }
+  return path;
+}
+
+static void HitIndexTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(300, 600);
+  tstring html = _t("<html><body><div style='position:relative'>");
+  for (int i = 0; i < 12; i++) {
+    html += _t("<p style='margin:0'>Line <b>bold</b></p>");
+    html += _t("<div style='height:10px'><p style='margin:15px 0 0 40px'>spills</p></div>");
+    html += _t("<span style='position:relative;top:-25px;left:120px'>up</span>");
+  }
+  html += _t("<div style='position:absolute;left:200px;top:40px;width:50px;height:300px'></div>");
+  html += _t("<p style='position:absolute;left:150px;top:5px;width:200px;height:20px'></p>");
+  html += _t("<div style='position:fixed;left:260px;top:0;width:30px;height:30px'></div>");
+  html += _t("</div></body></html>");
+  litehtml::document::ptr plain = document::createFromString(html.c_str(), &container, &ctx);
+  plain->set_hit_index(false);
+  plain->render(300, render_all);
+  litehtml::document::ptr indexed = document::createFromString(html.c_str(), &container, &ctx);
+  indexed->render(300, render_all);
+  assert(indexed->root()->select_one(_t("body > div"))->get_children_count() > 32);
+  for (int y = -10; y < indexed->height() + 10; y += 3) {
+    for (int x = -10; x < 320; x += 7) {
+      assert(ElementPath(indexed->root()->get_element_by_point(x, y, x, y)) == ElementPath(plain->root()->get_element_by_point(x, y, x, y)));
+    }
+  }
+}
+
+static void ZOrderTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_log container;
+  container.set_client_size(200, 600);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><head><style>div { border: 1px solid; height: 10px }</style></head><body style='margin:0'>"
+         "<div style='position:relative;z-index:0;height:100px;border-color:#000001'>"
+         "<div style='position:relative;z-index:2;border-color:#000002'><div style='position:absolute;z-index:-1;border-color:#000003'></div></div>"
+         "<div style='overflow:hidden;height:20px;border-color:#000004'><div style='position:relative;z-index:1;height:50px;border-color:#000005'></div></div>"
+         "<div style='position:relative;z-index:-1;border-color:#000006'></div>"
+         "<div style='position:relative;border-color:#000007'></div>"
+         "<div style='border-color:#000008'></div>"
+         "</div></body></html>"),
+      &container, &ctx);
+  doc->render(200, render_all);
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  // negative z-indexes first, then the flow, z-index auto and 0, positive ones; a context paints its own
+  // negative children after its borders
+  std::vector<std::string> order;
+  for (const auto& line : container.log)
+    if (!line.compare(0, 7, "borders")) order.push_back(line.substr(line.size() - 7, 6));
+  std::vector<std::string> expected = { "000000", "000000", "000001", "000006", "000004", "000008", "000007", "000005", "000002", "000003" };
+  assert(order == expected);
+  // the positioned child of the overflow box is painted inside its clip
+  assert(container.count("clip") == container.count("del_clip"));
+  for (size_t i = 0; i < container.log.size(); i++) {
+    if (container.log[i].find("000005") != std::string::npos) {
+      assert(container.log[i - 1] == "clip 2 14 196 20 000000 ");
+      assert(container.log[i + 1] == "del_clip");
+    }
+  }
+}
+
+static bool SameBox(const position& pos, int x, int y, int width, int height) {
+  return pos.x == x && pos.y == y && pos.width == width && pos.height == height;
+}
+
+static void DamageTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(200, 200);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><head><style>div { width: 50px; height: 20px } #a:hover { height: 50px }</style></head><body><div id='a'></div><div></div></body></html>"),
+      &container, &ctx);
+  doc->set_track_damage(true);
+  doc->render(200, render_all);
+  position::vector damage;
+  doc->take_damage(damage);
+  assert(damage.size() == 1);
+  doc->render(200, render_all);
+  doc->take_damage(damage);
+  assert(damage.empty());
+  position::vector redraw_boxes;
+  assert(doc->on_mouse_over(10, 10, 10, 10, redraw_boxes));
+  doc->render(200, render_all);
+  doc->take_damage(damage);
+  // the old 20px box of #a, its new 50px box and the moved sibling, merged into one
+  assert(damage.size() == 1);
+  assert(SameBox(damage[0], 8, 8, 50, 70));
+
+  tstring html = _t("<html><body>");
+  for (int i = 0; i < 20; i++) {
+    html += _t("<p>Paragraph with a few words to wrap into lines</p>");
+  }
+  html += _t("</body></html>");
+  litehtml::document::ptr lazy = document::createFromString(html.c_str(), &container, &ctx);
+  lazy->set_lazy_layout(true);
+  lazy->set_track_damage(true);
+  lazy->render(200, render_all);
+  lazy->take_damage(damage);
+  int estimated_height = lazy->height();
+  lazy->draw((uint_ptr)0, 0, 0, nullptr);
+  lazy->take_damage(damage);
+  // the first screen was laid out at once, the rest moved when the estimates were replaced
+  assert(damage.size() == 1);
+  assert(damage[0].y >= 200);
+  assert(damage[0].bottom() == std::max(estimated_height, lazy->height()));
+  assert(estimated_height != lazy->height());
+}
+
+static void ScrollTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(100, 100);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><body><div style='position:fixed;top:10px;left:20px;width:50px;height:10px'></div><div style='width:300px;height:500px'></div></body></html>"),
+      &container, &ctx);
+  doc->render(100, render_all);
+  position::vector redraw_boxes;
+  // the strip scrolled in, the fixed box and its copy moved with the content
+  assert(doc->scroll_to(0, 20, redraw_boxes));
+  assert(redraw_boxes.size() == 3);
+  assert(SameBox(redraw_boxes[0], 0, 80, 100, 20));
+  assert(SameBox(redraw_boxes[1], 20, 10, 50, 10));
+  assert(SameBox(redraw_boxes[2], 20, -10, 50, 10));
+  redraw_boxes.clear();
+  assert(!doc->scroll_to(0, 20, redraw_boxes));
+  assert(redraw_boxes.empty());
+  assert(doc->scroll_to(0, 5, redraw_boxes));
+  assert(redraw_boxes.size() == 3);
+  assert(SameBox(redraw_boxes[0], 0, 0, 100, 15));
+  assert(SameBox(redraw_boxes[2], 20, 25, 50, 10));
+  redraw_boxes.clear();
+  assert(doc->scroll_to(30, 5, redraw_boxes));
+  assert(redraw_boxes.size() == 3);
+  assert(SameBox(redraw_boxes[0], 70, 0, 30, 100));
+  assert(SameBox(redraw_boxes[2], -10, 10, 50, 10));
+  redraw_boxes.clear();
+  assert(doc->scroll_to(10, 5, redraw_boxes));
+  assert(SameBox(redraw_boxes[0], 0, 0, 20, 100));
+  redraw_boxes.clear();
+  // nothing can be reused after a jump over the whole client rect
+  assert(doc->scroll_to(10, 300, redraw_boxes));
+  assert(redraw_boxes.size() == 3);
+  assert(SameBox(redraw_boxes[0], 0, 0, 100, 100));
+}
+
+static void MetricsContainerTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  container.set_client_size(60, 100);
+  container.load_image_manifest(_t("# test images\nlogo.png 120 40\n"));
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><body style='margin:0'><p style='margin:0'>abc abc abc abc abc abc</p><img src='logo.png'><pre>mono</pre></body></html>"),
+      &container, &ctx);
+  uint_ptr font = doc->root()->get_font();
+  assert(container.text_width(_t("abc"), font) == 26);
+  doc->render(60, render_all);
+  element::ptr p = doc->root()->select_one(_t("p"));
+  assert(p->get_placement().height > 2 * p->line_height());
+  element::ptr img = doc->root()->select_one(_t("img"));
+  assert(img->get_placement().width == 120 && img->get_placement().height == 40);
+  container.reset_counts();
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  assert(container.counts().text > 0);
+}
+
+static void RasterTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_raster container(100, 60);
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><body style='margin:0;background:white'><div style='margin:10px;width:40px;height:20px;background:red;border:2px solid blue'></div></body></html>"),
+      &container, &ctx);
+  doc->render(100);
+  container.clear(web_color(255, 255, 255));
+  litehtml::position clip(0, 0, container.width(), container.height());
+  doc->draw((uint_ptr)0, 0, 0, &clip);
+  web_color inside = container.pixel(30, 20);
+  assert(inside.red == 255 && inside.green == 0 && inside.blue == 0);
+  web_color border = container.pixel(10, 20);
+  assert(border.red == 0 && border.blue == 255);
+  web_color outside = container.pixel(80, 50);
+  assert(outside.red == 255 && outside.green == 255 && outside.blue == 255);
+  assert(container.write_ppm("raster_test.ppm"));
+  container_raster golden(0, 0);
+  assert(golden.read_ppm("raster_test.ppm"));
+  assert(container.compare(golden) == 0);
+  container.clear(web_color(0, 0, 0));
+  assert(container.compare(golden) > 0);
+  remove("raster_test.ppm");
+}
+
+static void StatsTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  ctx.set_collect_stats(true);
+  container_metrics container;
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><head><style>p b { color: red }</style></head><body><p>Some <b>text</b></p><p>More</p></body></html>"), &container, &ctx);
+  doc->render(100, render_all);
+  doc->draw((uint_ptr)0, 0, 0, nullptr);
+  const document_stats& stats = doc->stats();
+#ifndef LITEHTML_NO_STATS
+  assert(stats.elements.at(_t("p")) == 2);
+  assert(stats.selectors_tested >= stats.selectors_matched && stats.selectors_matched > 0);
+  assert(stats.fonts_created > 0);
+  assert(stats.text_width_calls > 0);
+  assert(stats.element_renders > 0 && stats.max_element_renders() > 0);
+  assert(stats.line_boxes > 0);
+#endif
+  assert(stats.render_count == 1 && stats.draw_count == 1);
+#ifndef LITEHTML_NO_STATS
+  // the renders of each element are counted per document render, the total over all of them
+  long long renders = stats.element_renders;
+  int max_renders = stats.max_element_renders();
+  doc->render(100, render_all);
+  assert(stats.max_element_renders() == max_renders && stats.element_renders == 2 * renders);
+#endif
+}
+
+static void SelectorProfileTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  ctx.set_profile_selectors(true);
+  container_metrics container;
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><head><style>div p span:hover { color: red }</style></head><body><div><p><span>text</span></p></div></body></html>"), &container, &ctx);
+  doc->render(100, render_all);
+#ifndef LITEHTML_NO_STATS
+  std::vector<const selector_profile::entry*> top;
+  doc->get_selector_profile().top(doc->get_selector_profile().size(), top);
+  const selector_profile::entry* entry = nullptr;
+  for (const selector_profile::entry* e : top) {
+    if (e->source == _t("div p span:hover")) entry = e;
+  }
+  assert(entry && entry->origin.empty());
+  assert(entry->counters.attempts > 0 && entry->counters.hops > 0);
+  long long attempts = entry->counters.attempts;
+  position::vector redraw_boxes;
+  doc->on_mouse_over(1, 1, 1, 1, redraw_boxes);
+  assert(entry->counters.attempts > attempts);
+  assert(doc->get_selector_profile().report(5).find("div p span:hover") != std::string::npos);
+#endif
+}
+
+static void MemoryUsageTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  litehtml::document::ptr doc = document::createFromString(
+      _t("<html><head><style>p { text-transform: uppercase }</style></head><body><p class=\"a\">Some text</p><p>More</p><table><tr><td>cell</td></tr></table></body></html>"), &container, &ctx);
+  doc->render(100, render_all);
+  litehtml::memory_usage usage = doc->memory_usage();
+  assert(usage.elements.at(_t("p")).count == 2);
+  assert(usage.elements.at(_t("#text")).count >= 4);
+  assert(usage.texts.count >= 4 && usage.transformed_texts.count > 0);
+  assert(usage.attributes.count > 0 && usage.styles.count > 0 && usage.used_selectors.count > 0);
+  assert(usage.boxes.count > 0 && usage.table_grids.count == 1);
+  assert(usage.fonts.count > 0 && usage.stylesheets.count == 1);
+  assert(usage.total_bytes() > usage.elements.at(_t("p")).bytes);
+}
+
+class string_writer : public trace_writer {
+public:
+  std::string out;
+  void write(const char* data, size_t size) override { out.append(data, size); }
+};
+
+static void TraceTest() {
+  string_writer writer;
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  {
+    tracer::ptr tr = std::make_shared<tracer>(&writer);
+    ctx.set_tracer(tr);
+    container_metrics container;
+    litehtml::document::ptr doc = document::createFromString(
+        _t("<html><head><style>p { color: red }</style></head><body><p id=\"a\" class=\"x\">Some text</p></body></html>"), &container, &ctx);
+    doc->render(100, render_all);
+    doc->draw((uint_ptr)0, 0, 0, nullptr);
+    ctx.set_tracer(nullptr);
+  }
+  assert(writer.out.compare(0, 2, "[\n") == 0);
+  assert(writer.out.compare(writer.out.length() - 3, 3, "\n]\n") == 0);
+  assert(writer.out.find("\"name\":\"parse_styles\"") != std::string::npos);
+  assert(writer.out.find("\"name\":\"parse_stylesheet\"") != std::string::npos);
+  assert(writer.out.find("\"tag\":\"p\",\"id\":\"a\",\"class\":\"x\"") != std::string::npos);
+  assert(writer.out.find("\"name\":\"draw_text\"") != std::string::npos);
+}
+
 static void ParseTest() {
   context ctx;
   container_test container;
@@ -103,6 +833,28 @@ void documentTest() {
   CvtUnitsTest();
   MouseEventsTest();
   CreateElementTest();
+  AppendTextTest();
   DeviceChangeTest();
+  LazyLayoutTest();
+  LazyEstimateTest();
+  ParallelLayoutTest();
+  FixedTableLayoutTest();
+  FixedTableRelayoutTest();
+  TableCaptionTreeTest();
+  TableHitTest();
+  TableSpacingClipTest();
+  DisplayListTest();
+  TextRunTest();
+  InkCullingTest();
+  HitIndexTest();
+  ZOrderTest();
+  DamageTest();
+  ScrollTest();
+  MetricsContainerTest();
+  RasterTest();
+  StatsTest();
+  SelectorProfileTest();
+  MemoryUsageTest();
+  TraceTest();
   ParseTest();
 }
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include <assert.h>
+#include <string>
+#include <vector>
 #include "litehtml.h"
+#include "litehtml/table.h"
 #include "test/container_test.h"
+#include "metrics/container_metrics.h"
 using namespace litehtml;
 
+extern const litehtml::tchar_t master_css[];
+
 static void Test() {
   context ctx;
   container_test container;
@@ -10,6 +16,123 @@ static void Test() {
   doc->render(50, render_all);
 }
 
+// the boxes of every element in document order, for comparing two layouts; skipped white space
+// keeps whatever position it had before, so it counts as an empty box
+static void CollectBoxes(const element::ptr& el, std::vector<position>& boxes) {
+  boxes.push_back(el->skip() ? position() : el->get_placement());
+  for (size_t i = 0; i < el->get_children_count(); i++) CollectBoxes(el->get_child((int)i), boxes);
+}
+
+static bool SameBoxes(const std::vector<position>& a, const std::vector<position>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].width != b[i].width || a[i].height != b[i].height) return false;
+  return true;
+}
+
+static std::vector<position> FreshLayout(context& ctx, container_metrics& container, const tchar_t* html, int width, const tchar_t* hover) {
+  container.set_client_size(width, 600);
+  litehtml::document::ptr doc = document::createFromString(html, &container, &ctx);
+  doc->render(width, render_all);
+  if (hover) {
+    position pos = doc->root()->select_one(hover)->get_child(0)->get_placement();
+    position::vector redraw_boxes;
+    doc->on_mouse_over(pos.x + 1, pos.y + 1, pos.x + 1, pos.y + 1, redraw_boxes);
+    doc->render(width, render_all);
+  }
+  std::vector<position> boxes;
+  CollectBoxes(doc->root(), boxes);
+  return boxes;
+}
+
+static void LineBreakReuseTest() {
+  context ctx;
+  ctx.load_master_stylesheet(master_css);
+  container_metrics container;
+  const tchar_t* html =
+      _t("<html><head><style>#s:hover { display: none }</style></head><body>"
+         "<p>Plain words in a <span id=s>paragraph</span> that wraps over a few lines at the narrow widths of this test.</p>"
+         "<p style='text-align:center'>Centered <b>bold</b> and <span style='padding:0 3px;border:1px solid'>boxed</span> words.</p>"
+         "<p style='text-align:right'>Right aligned text that is long enough to wrap somewhere.</p>"
+         "<p style='text-align:justify'>Justified text with enough words to fill several lines when narrow.</p>"
+         "<p style='text-indent:20px'>Indented first line of a paragraph with <i>inline</i> content.</p>"
+         "</body></html>");
+  container.set_client_size(600, 600);
+  litehtml::document::ptr doc = document::createFromString(html, &container, &ctx);
+  doc->render(600, render_all);
+  // small steps stay inside the range the breaks were saved for, big ones leave it
+  int widths[] = { 600, 598, 590, 601, 560, 400, 403, 320, 321, 900, 899, 600 };
+  for (int width : widths) {
+    container.set_client_size(width, 600);
+    doc->render(width, render_all);
+    std::vector<position> boxes;
+    CollectBoxes(doc->root(), boxes);
+    assert(SameBoxes(boxes, FreshLayout(ctx, container, html, width, nullptr)));
+  }
+  // a child that is hidden on hover makes the paragraph break its lines again
+  position pos = doc->root()->select_one(_t("#s"))->get_child(0)->get_placement();
+  position::vector redraw_boxes;
+  assert(doc->on_mouse_over(pos.x + 1, pos.y + 1, pos.x + 1, pos.y + 1, redraw_boxes));
+  int hover_widths[] = { 600, 597, 420 };
+  for (int width : hover_widths) {
+    container.set_client_size(width, 600);
+    doc->render(width, render_all);
+    std::vector<position> boxes;
+    CollectBoxes(doc->root(), boxes);
+    assert(SameBoxes(boxes, FreshLayout(ctx, container, html, width, _t("#s"))));
+  }
+}
+
+// the cells of each row are given as colspan, rowspan pairs and named by letters in the order they are
+// added; every expected row lists the letter of the cell starting in each column, '.' for none
+static void CheckTableGrid(const std::vector<std::vector<std::pair<int, int>>>& rows, const std::vector<std::string>& expected) {
+  container_test container;
+  litehtml::document::ptr doc = std::make_shared<litehtml::document>(&container, nullptr);
+  string_map no_attrs;
+  elements_vector cells;
+  table_grid grid;
+  for (const auto& row : rows) {
+    element::ptr tr = doc->create_element(_t("tr"), no_attrs);
+    grid.begin_row(tr);
+    for (const auto& span : row) {
+      string_map attrs;
+      attrs[_t("colspan")] = tstring(1, (tchar_t)(_t('0') + span.first));
+      attrs[_t("rowspan")] = tstring(1, (tchar_t)(_t('0') + span.second));
+      element::ptr td = doc->create_element(_t("td"), attrs);
+      grid.add_cell(td);
+      cells.push_back(td);
+    }
+  }
+  grid.finish();
+  assert(grid.rows_count() == (int)expected.size());
+  for (int row = 0; row < grid.rows_count(); row++) {
+    assert(grid.cols_count() == (int)expected[row].size());
+    for (int col = 0; col < grid.cols_count(); col++) {
+      element::ptr el = grid.cell(col, row)->el;
+      char name = '.';
+      for (size_t i = 0; i < cells.size(); i++)
+        if (cells[i] == el) name = (char)('A' + i);
+      assert(name == expected[row][col]);
+    }
+  }
+}
+
+static void TableGridTest() {
+  // rowspan reserves its column in the next rows
+  CheckTableGrid({ { {1, 2}, {1, 1} }, { {1, 1} } }, { "AB", ".C" });
+  CheckTableGrid({ { {1, 1}, {1, 3}, {1, 1} }, { {1, 1}, {1, 1} }, { {1, 1}, {1, 1} } }, { "ABC", "D.E", "F.G" });
+  // colspan leaves empty cells after the spanning one
+  CheckTableGrid({ { {2, 1}, {1, 1} }, { {1, 1}, {1, 1}, {1, 1} } }, { "A.B", "CDE" });
+  // short and empty rows are padded to the widest one
+  CheckTableGrid({ { {1, 1} }, { {1, 1}, {1, 1}, {1, 1} }, {} }, { "A..", "BCD", "..." });
+  // a rowspan past the last row adds no rows
+  CheckTableGrid({ { {1, 5}, {1, 1} }, { {1, 1} } }, { "AB", ".C" });
+  // a cell spanning both ways reserves only its first column in the next rows
+  CheckTableGrid({ { {2, 2}, {1, 1} }, { {1, 1}, {1, 1} } }, { "A.B", ".CD" });
+}
+
 void layoutGlobalTest() {
   Test();
+  LineBreakReuseTest();
+  TableGridTest();
 }
\ No newline at end of file
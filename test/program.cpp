@@ -6,11 +6,13 @@ extern const litehtml::tchar_t master_css[] =
 ,0
 };
 
+void allocationTest();
 void contextTest();
 void cssTest();
 void documentTest();
 void layoutGlobalTest();
 void mediaQueryTest();
+void scalingTest(double max_exponent);
 void webColorTest();
 
 #if _HASPAUSE
@@ -30,6 +32,8 @@ int main(int argc, char **argv) {
 	case 4: layoutGlobalTest(); break;
 	case 5: mediaQueryTest(); break;
 	case 6: webColorTest(); break;
+	case 7: scalingTest(argc > 2 ? atof(argv[2]) : 1.5); break;
+	case 8: allocationTest(); break;
 	default: mainPause("Unknown test."); break;
 	}
 	return 0;
@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "litehtml.h"
+#include "metrics/container_metrics.h"
+using namespace litehtml;
+
+extern const litehtml::tchar_t master_css[];
+
+// every shape is timed at n, 2n, 4n and 8n and the slope of log(time) over log(n) must stay
+// below the allowed exponent, so an accidental quadratic loop fails the test
+
+typedef std::string (*shape_func)(int n);
+
+struct scaling_shape
+{
+  const char* name;
+  shape_func  html;
+  int         base;
+  bool        render;
+};
+
+static std::string RowspanShape(int n) {
+  std::string html = "<table>";
+  for (int i = 0; i < n; i++)
+    html += i % 2 ? "<tr><td>c</td></tr>" : "<tr><td rowspan=2>a</td><td>b</td></tr>";
+  return html + "</table>";
+}
+
+static std::string CommentShape(int n) {
+  std::string html = "<style>";
+  for (int i = 0; i < n; i++)
+    html += "/* rule " + std::to_string(i) + " */ .c" + std::to_string(i) + " { color: red }";
+  return html + "</style><p>text</p>";
+}
+
+static std::string TableFixShape(int n) {
+  // a css table, which the html parser leaves alone; every row is followed by a stray cell that
+  // the table fixup wraps into an anonymous row, inside the anonymous row group of the table
+  std::string html = "<div style='display:table'>";
+  for (int i = 0; i < n; i++)
+    html += "<div style='display:table-row'><div style='display:table-cell'>a</div></div><div style='display:table-cell'>b</div>";
+  return html + "</div>";
+}
+
+static std::string FloatShape(int n) {
+  std::string html = "<div style='width:1000px'>";
+  for (int i = 0; i < n; i++)
+    html += "<div style='float:left;width:" + std::to_string(80 + (i % 5) * 20) + "px;height:" + std::to_string(40 + (i % 3) * 15) + "px'>x</div>";
+  return html + "</div>";
+}
+
+static std::string NthChildShape(int n) {
+  std::string html = "<style>li:nth-child(3n+1) { color: red } li:nth-last-child(2) { color: blue } li:nth-of-type(odd) { color: green }</style><ul>";
+  for (int i = 0; i < n; i++)
+    html += "<li>item</li>";
+  return html + "</ul>";
+}
+
+static long long TimeShape(const std::string& html, bool render) {
+  long long best = -1;
+  for (int run = 0; run < 3; run++) {
+    context ctx;
+    ctx.load_master_stylesheet(master_css);
+    container_metrics container;
+    container.set_client_size(1000, 600);
+    auto start = std::chrono::steady_clock::now();
+    document::ptr doc = document::createFromUTF8(html.c_str(), &container, &ctx);
+    if (render) doc->render(1000);
+    long long ns = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (best < 0 || ns < best) best = ns;
+  }
+  return best;
+}
+
+static double MeasureExponent(const scaling_shape& shape) {
+  // least squares slope over the four sizes
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (int k = 0; k < 4; k++) {
+    double x = log((double)(shape.base << k));
+    double y = log((double)TimeShape(shape.html(shape.base << k), shape.render) + 1);
+    sx += x, sy += y, sxx += x * x, sxy += x * y;
+  }
+  return (4 * sxy - sx * sy) / (4 * sxx - sx * sx);
+}
+
+void scalingTest(double max_exponent) {
+  scaling_shape shapes[] = {
+    { "rowspan", RowspanShape, 100, true },
+    { "css_comments", CommentShape, 200, false },
+    { "table_fixup", TableFixShape, 50, false },
+    { "float_lines", FloatShape, 25, true },
+    { "nth_child", NthChildShape, 100, false },
+  };
+  for (const auto& shape : shapes) {
+    double exponent = MeasureExponent(shape);
+    printf("%-20s exponent %.2f (max %.2f)\n", shape.name, exponent, max_exponent);
+    assert(exponent <= max_exponent);
+  }
+}